@@ -0,0 +1,482 @@
+// BENCHMARK
+//
+// Times each per tile stage of a step on its own, and a whole step, at tile counts from { --min-tiles } to { --max-tiles },
+// going up 10x at a time (1K, 10K, 100K, 1M, 10M by default).
+// usage: benchmark [--min-tiles N] [--max-tiles N] [--min-time SECONDS] [--only NAME] [--isa scalar|sse2|avx2|avx512] [--threads N]
+//        [--broadphase none|grid|sap] [--spawn uniform|clustered] [--seed N] [--json PATH]
+//        benchmark --check sincos [--isa scalar|sse2|avx2|avx512]
+// e.g.   benchmark --max-tiles 1000000 --json before.json
+//
+// Each benchmark is run once to warm up, then timed one run at a time until { --min-time } has passed (and at least 5 runs),
+// the median and fastest runs are reported as ns per tile, and as GB/s of the tile columns each stage reads and writes.
+// Small counts sit in cache and large ones stream from memory, so the table shows where each stage goes memory bound.
+// --json writes the same results for tools to compare, e.g. before and after a change, or between instruction sets.
+//
+// --check sincos times nothing, it checks the error bound claimed for the kernels' sincos instead (see check_sincos).
+
+
+#include "collision.h"       // for get_eat_query, get_arena_query
+#include "frame_stats.h"     // for get_clock_nanoseconds
+#include "simulation.h"      // for simulation_t
+#include "tile_kernels.h"    // for update_tiles, eat_tiles, bounce_tiles, select_tile_kernels
+#include "tile_transforms.h" // for tile_transforms_t, build_tile_transforms
+#include "utility.h"         // for aligned_allocate, aligned_release
+
+#include <algorithm>         // for std::sort, std::max
+#include <bit>               // for std::bit_cast
+#include <cmath>             // for std::sin, std::cos, std::abs
+#include <cstdint>           // for std::uint64_t
+#include <cstdio>            // for std::printf, std::fprintf
+#include <cstdlib>           // for std::atof, std::strtoul, std::strtoull
+#include <cstring>           // for std::strcmp
+#include <vector>            // for std::vector
+
+
+/// <summary>
+/// printed when the options can't be parsed
+/// </summary>
+char const* const BENCHMARK_USAGE =
+  "usage: benchmark [--min-tiles N] [--max-tiles N] [--min-time SECONDS] [--only NAME] [--isa scalar|sse2|avx2|avx512] [--threads N]\n"
+  "                 [--broadphase none|grid|sap] [--spawn uniform|clustered] [--seed N] [--json PATH]\n"
+  "       benchmark --check sincos [--isa scalar|sse2|avx2|avx512]\n";
+
+/// <summary>
+/// fewest timed runs of each benchmark, however long they take
+/// </summary>
+unsigned const BENCHMARK_MIN_RUNS = 5u;
+
+/// <summary>
+/// 1 in this many tiles expire before each run of the respawn benchmark
+/// </summary>
+unsigned const BENCHMARK_RESPAWN_EVERY = 100u;
+
+
+/// <summary>
+/// everything a benchmark runs against, one per tile count
+/// </summary>
+struct benchmark_state_t
+{
+  simulation_t simulation;
+  tile_transforms_t transforms;
+  arena_query_t arena_query;
+};
+
+
+/// <summary>
+/// one stage to time
+/// </summary>
+struct benchmark_t
+{
+  char const* name;
+
+  // bytes of tile columns read and written per tile, for GB/s, 0 if it doesn't mean much (e.g. a whole step)
+  double bytes_per_tile;
+
+  // called before each run, not timed, may be nullptr
+  void (*prepare) (benchmark_state_t& state);
+  void (*run) (benchmark_state_t& state);
+};
+
+
+// BENCHMARKS
+
+static double const STEP_ELAPSED = 1.0 / 60.0;
+
+static void run_update (benchmark_state_t& state)
+{
+  state.simulation.tiles.update (STEP_ELAPSED, state.simulation.jobs);
+}
+
+static void run_eat (benchmark_state_t& state)
+{
+  simulation_t& simulation = state.simulation;
+  eat_tiles (simulation.tiles, get_eat_query (simulation.players, USER_PLAYER, simulation.config.sprites),
+    simulation.arena, simulation.jobs);
+  reset_frame_arena (simulation.arena);
+}
+
+static void run_bounce (benchmark_state_t& state)
+{
+  bounce_tiles (state.simulation.tiles, state.arena_query, state.simulation.jobs);
+}
+
+static void prepare_respawn (benchmark_state_t& state)
+{
+  tiles_t& tiles = state.simulation.tiles;
+  for (unsigned i = 0; i < tiles.count; i += BENCHMARK_RESPAWN_EVERY)
+  {
+    mark_tile_for_respawn (tiles, i);
+  }
+}
+
+static void run_respawn (benchmark_state_t& state)
+{
+  replace_expired_tiles (state.simulation.tiles, state.simulation.arena, state.simulation.jobs);
+  reset_frame_arena (state.simulation.arena);
+}
+
+static void run_transform (benchmark_state_t& state)
+{
+  build_tile_transforms (state.transforms, state.simulation.tiles, state.simulation.config.sprites, 0.5f, state.simulation.jobs);
+}
+
+static void run_step (benchmark_state_t& state)
+{
+  state.simulation.step (1.0 / state.simulation.config.step_rate, 0);
+}
+
+
+// bytes per tile, from which tile columns each kernel loads and stores (see tile_kernels.inl)
+// a float column is 4 bytes, the object id column 1
+static benchmark_t const BENCHMARKS [] =
+{
+  // loads pos, vel, angle, lifetime, stores prev pos, pos, angle, lifetime
+  { "update", 4.0 * 6.0 + 4.0 * 6.0, nullptr, run_update },
+  // loads id, pos
+  { "eat", 1.0 + 4.0 * 2.0, nullptr, run_eat },
+  // loads id, pos, vel, stores pos, vel
+  { "bounce", 1.0 + 4.0 * 4.0 + 4.0 * 4.0, nullptr, run_bounce },
+  // scans a bit per tile, then rewrites every column of the tiles that expired, from 16 bytes of random numbers each
+  { "respawn", 1.0 / 8.0 + (4.0 * 8.0 + 1.0 + 16.0) / BENCHMARK_RESPAWN_EVERY, prepare_respawn, run_respawn },
+  // loads id, pos, prev pos, angle, stores 6 floats of transform
+  { "transform", 1.0 + 4.0 * 5.0 + 4.0 * 6.0, nullptr, run_transform },
+  // a whole step, every stage above plus the player and the tile v tile broadphase, if any
+  { "step", 0.0, nullptr, run_step },
+};
+
+
+// RESULTS
+
+struct benchmark_result_t
+{
+  char const* name;
+  unsigned num_tiles;
+  unsigned runs;
+  std::uint64_t median_nanoseconds;
+  std::uint64_t min_nanoseconds;
+  double bytes_per_tile;
+};
+
+static double get_ns_per_tile (benchmark_result_t const& result, std::uint64_t nanoseconds)
+{
+  return (double)nanoseconds / (double)result.num_tiles;
+}
+
+/// <returns>0 if the benchmark has no bytes per tile</returns>
+static double get_gb_per_second (benchmark_result_t const& result, std::uint64_t nanoseconds)
+{
+  // bytes per nanosecond is GB/s
+  return nanoseconds > 0u ? result.bytes_per_tile * (double)result.num_tiles / (double)nanoseconds : 0.0;
+}
+
+/// <summary>
+/// warm { benchmark } up, then time runs of it until { min_seconds } have passed
+/// </summary>
+static benchmark_result_t run_benchmark (benchmark_t const& benchmark, benchmark_state_t& state, double min_seconds,
+  std::vector <std::uint64_t>& times)
+{
+  // the first run pages in anything not touched yet, and fills the caches
+  if (benchmark.prepare != nullptr)
+  {
+    benchmark.prepare (state);
+  }
+  benchmark.run (state);
+
+  times.clear ();
+  std::uint64_t const min_nanoseconds = (std::uint64_t)(min_seconds * 1e9);
+  std::uint64_t total = 0;
+  while (times.size () < BENCHMARK_MIN_RUNS || total < min_nanoseconds)
+  {
+    if (benchmark.prepare != nullptr)
+    {
+      benchmark.prepare (state);
+    }
+
+    std::uint64_t const start = get_clock_nanoseconds ();
+    benchmark.run (state);
+    std::uint64_t const time = get_clock_nanoseconds () - start;
+
+    times.push_back (time);
+    total += time;
+  }
+  std::sort (times.begin (), times.end ());
+
+  benchmark_result_t result;
+  result.name = benchmark.name;
+  result.num_tiles = state.simulation.tiles.count;
+  result.runs = (unsigned)times.size ();
+  result.median_nanoseconds = times [times.size () / 2u];
+  result.min_nanoseconds = times.front ();
+  result.bytes_per_tile = benchmark.bytes_per_tile;
+  return result;
+}
+
+static void print_result (benchmark_result_t const& result)
+{
+  std::printf ("%-10s %10u %7u %12.3f %10.3f %10.3f",
+    result.name, result.num_tiles, result.runs, (double)result.median_nanoseconds / 1e3,
+    get_ns_per_tile (result, result.median_nanoseconds), get_ns_per_tile (result, result.min_nanoseconds));
+  if (result.bytes_per_tile > 0.0)
+  {
+    std::printf (" %8.2f\n", get_gb_per_second (result, result.median_nanoseconds));
+  }
+  else
+  {
+    std::printf (" %8s\n", "-");
+  }
+}
+
+static bool write_results_json (char const* path, std::vector <benchmark_result_t> const& results, unsigned num_threads)
+{
+  std::FILE* const file = std::fopen (path, "w");
+  if (file == nullptr)
+  {
+    return false;
+  }
+
+  // benchmark names are plain identifiers, nothing needs escaping
+  std::fprintf (file, "{\n  \"isa\": \"%s\",\n  \"threads\": %u,\n  \"results\": [\n", get_tile_kernels ().name, num_threads);
+  for (std::size_t i = 0; i < results.size (); i++)
+  {
+    benchmark_result_t const& result = results [i];
+    std::fprintf (file, "    { \"name\": \"%s\", \"tiles\": %u, \"runs\": %u, \"median_ns\": %llu, \"min_ns\": %llu, "
+      "\"ns_per_tile\": %.4f, \"min_ns_per_tile\": %.4f, \"bytes_per_tile\": %.4f, \"gb_per_s\": %.4f }%s\n",
+      result.name, result.num_tiles, result.runs,
+      (unsigned long long)result.median_nanoseconds, (unsigned long long)result.min_nanoseconds,
+      get_ns_per_tile (result, result.median_nanoseconds), get_ns_per_tile (result, result.min_nanoseconds),
+      result.bytes_per_tile, get_gb_per_second (result, result.median_nanoseconds),
+      i + 1u < results.size () ? "," : "");
+  }
+  std::fprintf (file, "  ]\n}\n");
+  return std::fclose (file) == 0;
+}
+
+
+// SINCOS CHECK
+//
+// The transforms' sincos is claimed to be within { SINCOS_MAX_ERROR } of the true sin and cos (see tile_kernels.inl)
+// for every float in [-pi, pi], where the tile angles are kept, and on out to |angle| < { SINCOS_CHECK_RANGE }.
+// Rather than sampling, every one of those floats (about 2.3 billion) is run through the kernels in use
+// and compared with the C library's double precision sin and cos.
+
+double const SINCOS_MAX_ERROR = 8e-8;
+float const SINCOS_CHECK_RANGE = 8192.f;
+unsigned const SINCOS_CHECK_BATCH = 1u << 16; // floats per call to the kernel, a multiple of 16
+
+/// <returns>true if every angle was within { SINCOS_MAX_ERROR }</returns>
+static bool check_sincos ()
+{
+  tile_kernels_t const& kernels = get_tile_kernels ();
+  float* const angles = (float*)aligned_allocate (SINCOS_CHECK_BATCH * sizeof (float));
+  float* const sin_angles = (float*)aligned_allocate (SINCOS_CHECK_BATCH * sizeof (float));
+  float* const cos_angles = (float*)aligned_allocate (SINCOS_CHECK_BATCH * sizeof (float));
+
+  // positive floats are ordered the same as their bits, so [0, range) is every bit pattern below the range's
+  std::uint32_t const pi_bits = std::bit_cast <std::uint32_t> ((float)3.14159265358979323846);
+  std::uint32_t const range_bits = std::bit_cast <std::uint32_t> (SINCOS_CHECK_RANGE);
+  std::uint32_t const sign_bits [2] = { 0u, 0x80000000u };
+
+  double max_error_pi = 0.0;    // |angle| <= pi
+  double max_error_range = 0.0; // |angle| < range
+  float worst_angle = 0.f;
+  std::uint64_t num_checked = 0;
+
+  for (std::uint32_t const sign : sign_bits)
+  {
+    for (std::uint32_t first = 0; first < range_bits; first += SINCOS_CHECK_BATCH)
+    {
+      unsigned const count = std::min (SINCOS_CHECK_BATCH, range_bits - first);
+      for (unsigned i = 0; i < SINCOS_CHECK_BATCH; i++)
+      {
+        angles [i] = i < count ? std::bit_cast <float> ((first + i) | sign) : 0.f;
+      }
+
+      kernels.sincos (angles, SINCOS_CHECK_BATCH, sin_angles, cos_angles);
+
+      for (unsigned i = 0; i < count; i++)
+      {
+        double const angle = angles [i];
+        double const error = std::max (std::abs (sin_angles [i] - std::sin (angle)), std::abs (cos_angles [i] - std::cos (angle)));
+        if (error > max_error_range)
+        {
+          max_error_range = error;
+          worst_angle = angles [i];
+        }
+        if (first + i <= pi_bits)
+        {
+          max_error_pi = std::max (max_error_pi, error);
+        }
+      }
+      num_checked += count;
+    }
+  }
+
+  aligned_release (angles);
+  aligned_release (sin_angles);
+  aligned_release (cos_angles);
+
+  bool const passed = max_error_range <= SINCOS_MAX_ERROR;
+  std::printf ("sincos, %s kernels, %llu angles: max error %.3g in [-pi, pi], %.3g for |angle| < %g (at %.9g), limit %.3g: %s\n",
+    kernels.name, (unsigned long long)num_checked, max_error_pi, max_error_range, (double)SINCOS_CHECK_RANGE, (double)worst_angle,
+    SINCOS_MAX_ERROR, passed ? "passed" : "FAILED");
+  return passed;
+}
+
+
+int main (int argc, char** argv)
+{
+  unsigned min_tiles = 1000u;
+  unsigned max_tiles = 10000000u;
+  double min_seconds = 0.25;
+  char const* only = nullptr;
+  char const* json_path = nullptr;
+  char const* check = nullptr;
+  simulation_config_t config = get_default_simulation_config ();
+
+  // every option takes a value, so the options come in pairs
+  if (argc % 2 == 0)
+  {
+    std::printf ("option '%s' needs a value\n%s", argv [argc - 1], BENCHMARK_USAGE);
+    return 1;
+  }
+
+  for (int i = 1; i + 1 < argc; i += 2)
+  {
+    if (std::strcmp (argv [i], "--min-tiles") == 0)
+    {
+      min_tiles = (unsigned)std::strtoul (argv [i + 1], nullptr, 10);
+    }
+    else if (std::strcmp (argv [i], "--max-tiles") == 0)
+    {
+      max_tiles = (unsigned)std::strtoul (argv [i + 1], nullptr, 10);
+    }
+    else if (std::strcmp (argv [i], "--min-time") == 0)
+    {
+      min_seconds = std::atof (argv [i + 1]);
+    }
+    else if (std::strcmp (argv [i], "--only") == 0)
+    {
+      only = argv [i + 1];
+    }
+    else if (std::strcmp (argv [i], "--check") == 0)
+    {
+      check = argv [i + 1];
+    }
+    else if (std::strcmp (argv [i], "--json") == 0)
+    {
+      json_path = argv [i + 1];
+    }
+    else if (std::strcmp (argv [i], "--broadphase") == 0)
+    {
+      if (std::strcmp (argv [i + 1], "none") == 0)
+      {
+        config.tile_broadphase = tile_broadphase_t::NONE;
+      }
+      else if (std::strcmp (argv [i + 1], "grid") == 0)
+      {
+        config.tile_broadphase = tile_broadphase_t::GRID;
+      }
+      else if (std::strcmp (argv [i + 1], "sap") == 0)
+      {
+        config.tile_broadphase = tile_broadphase_t::SWEEP_AND_PRUNE;
+      }
+      else
+      {
+        std::printf ("unknown broadphase '%s'\n%s", argv [i + 1], BENCHMARK_USAGE);
+        return 1;
+      }
+    }
+    else if (std::strcmp (argv [i], "--spawn") == 0)
+    {
+      if (std::strcmp (argv [i + 1], "uniform") == 0)
+      {
+        config.tile_spawn = tile_spawn_t::UNIFORM;
+      }
+      else if (std::strcmp (argv [i + 1], "clustered") == 0)
+      {
+        config.tile_spawn = tile_spawn_t::CLUSTERED;
+      }
+      else
+      {
+        std::printf ("unknown spawn pattern '%s'\n%s", argv [i + 1], BENCHMARK_USAGE);
+        return 1;
+      }
+    }
+    else if (std::strcmp (argv [i], "--seed") == 0)
+    {
+      config.seed = std::strtoull (argv [i + 1], nullptr, 10);
+    }
+    else if (std::strcmp (argv [i], "--threads") == 0)
+    {
+      config.num_threads = (unsigned)std::strtoul (argv [i + 1], nullptr, 10);
+    }
+    else if (std::strcmp (argv [i], "--isa") == 0)
+    {
+      kernel_isa_t isa;
+      if (!parse_kernel_isa (argv [i + 1], isa))
+      {
+        std::printf ("unknown instruction set '%s'\n%s", argv [i + 1], BENCHMARK_USAGE);
+        return 1;
+      }
+      if (!select_tile_kernels (isa))
+      {
+        std::printf ("this CPU doesn't support '%s'\n%s", argv [i + 1], BENCHMARK_USAGE);
+        return 1;
+      }
+    }
+    else
+    {
+      std::printf ("unknown option '%s'\n%s", argv [i], BENCHMARK_USAGE);
+      return 1;
+    }
+  }
+
+  if (check != nullptr)
+  {
+    if (std::strcmp (check, "sincos") != 0)
+    {
+      std::printf ("unknown check '%s'\n%s", check, BENCHMARK_USAGE);
+      return 1;
+    }
+    return check_sincos () ? 0 : 1;
+  }
+
+  std::vector <benchmark_result_t> results;
+  std::vector <std::uint64_t> times;
+  unsigned num_threads = 0;
+
+  std::printf ("%-10s %10s %7s %12s %10s %10s %8s\n", "benchmark", "tiles", "runs", "median us", "ns/tile", "min", "GB/s");
+  for (unsigned long long num_tiles = min_tiles; num_tiles > 0u && num_tiles <= max_tiles; num_tiles *= 10u)
+  {
+    benchmark_state_t state;
+    config.num_tiles = (unsigned)num_tiles;
+    initialise_simulation (state.simulation, config);
+    initialise_tile_transforms (state.transforms, state.simulation.tiles.capacity);
+    state.arena_query = get_arena_query (state.simulation.walls, config.sprites);
+    num_threads = state.simulation.jobs.num_threads;
+
+    for (benchmark_t const& benchmark : BENCHMARKS)
+    {
+      if (only != nullptr && std::strcmp (only, benchmark.name) != 0)
+      {
+        continue;
+      }
+
+      results.push_back (run_benchmark (benchmark, state, min_seconds, times));
+      print_result (results.back ());
+    }
+
+    release_tile_transforms (state.transforms);
+    release_simulation (state.simulation);
+  }
+
+  std::printf ("%s kernels, %u threads\n", get_tile_kernels ().name, num_threads);
+
+  if (json_path != nullptr && !write_results_json (json_path, results, num_threads))
+  {
+    std::printf ("couldn't write results '%s'\n", json_path);
+    return 1;
+  }
+
+  return 0;
+}
@@ -1,10 +1,13 @@
 #include "collision.h"
 
-#include "player.h" // for player_t
-#include "tiles.h"  // for tile_t
-#include "walls.h"  // for wall_t
+#include "player.h"          // for players_t
+#include "spatial_grid.h"    // for spatial_grid_t
+#include "sweep_and_prune.h" // for sweep_and_prune_t
+#include "tile_kernels.h"    // for eat_tiles, bounce_tiles
+#include "tiles.h"           // for tiles_t
+#include "walls.h"           // for walls_t
 
-#include "timer.h"
+#include <cmath>             // for std::abs
 
 
 /// <summary>
@@ -15,7 +18,7 @@
 static bool is_overlapping (float lhs_position_x, float lhs_position_y, float lhs_width, float lhs_height,
   float rhs_position_x, float rhs_position_y, float rhs_width, float rhs_height)
 {
-  float const overlap = 4.f; // allow objects to overlap by this amount
+  float const overlap = COLLISION_OVERLAP; // allow objects to overlap by this amount
 
   // get left and right boundaries of lhs AABB
   float const lhs_bound_left  = lhs_position_x - (lhs_width - overlap) / 2.f;
@@ -43,13 +46,171 @@ static bool is_overlapping (float lhs_position_x, float lhs_position_y, float lh
 }
 
 
-timer MyTimer;
+// COLLISION HANDLERS
 
+void collision_handler_t <PLAYER_TYPE, TILE_TYPE>::on_collision (players_t& players, unsigned player, object_id_t tile_id)
+{
+  // a normal player that eats a wide tile becomes wide
+  // a wide player stays wide, whatever it eats
+  if (get_column <player_state_t> (players) [player] == PLAYER_ID_NORMAL && tile_id == TILE_ID_WIDE)
+  {
+    get_column <player_new_state_t> (players) [player] = PLAYER_ID_WIDE;
+  }
+}
+
+void collision_handler_t <PLAYER_TYPE, WALL_TYPE>::on_collision (players_t& players, unsigned player, walls_t const& walls, unsigned wall,
+  sprite_table_t const& sprites)
+{
+  // get the player's size as required by the following code
+  sprite_metrics_t const& size = get_sprite_metrics (sprites, get_column <player_state_t> (players) [player]);
+  player_real_t& position_x = get_column <player_position_x_t> (players) [player];
+  player_real_t& position_y = get_column <player_position_y_t> (players) [player];
+  wall_real_t const wall_size = get_column <wall_size_t> (walls) [wall];
+  wall_real_t const wall_x = get_column <wall_position_x_t> (walls) [wall];
+  wall_real_t const wall_y = get_column <wall_position_y_t> (walls) [wall];
+
+  // position response
+  switch (get_column <wall_object_id_t> (walls) [wall])
+  {
+    case WALL_ID_LEFT:
+      position_x = wall_x + wall_size / 2.0;
+      position_x += size.width / 2.0;
+      break;
+    case WALL_ID_RIGHT:
+      position_x = wall_x - wall_size / 2.0;
+      position_x -= size.width / 2.0;
+      break;
+    case WALL_ID_TOP:
+      position_y = wall_y - wall_size / 2.0;
+      position_y -= size.height / 2.0;
+      break;
+    case WALL_ID_BOTTOM:
+      position_y = wall_y + wall_size / 2.0;
+      position_y += size.height / 2.0;
+      break;
+    default:
+      break;
+  }
+}
+
+
+/// <summary>
+/// if 2 tiles overlap, move them apart and bounce them off each other
+/// uses the same overlap allowance as is_overlapping
+/// </summary>
+static void collision_resolve_tile_tile (tiles_t& tiles, float const* half_width, float const* half_height,
+  unsigned lhs, unsigned rhs)
+{
+  float const overlap = COLLISION_OVERLAP; // allow objects to overlap by this amount
+
+  auto const pos_x = get_column <tile_pos_x_t> (tiles);
+  auto const pos_y = get_column <tile_pos_y_t> (tiles);
+  auto const vel_x = get_column <tile_vel_x_t> (tiles);
+  auto const vel_y = get_column <tile_vel_y_t> (tiles);
+
+  float const distance_x = pos_x [rhs] - pos_x [lhs];
+  float const distance_y = pos_y [rhs] - pos_y [lhs];
+
+  // how far the tiles' AABBs have sunk into each other along each axis, <= 0 means no overlap
+  float const penetration_x = half_width [lhs] + half_width [rhs] - overlap - std::abs (distance_x);
+  if (penetration_x <= 0.f)
+  {
+    return;
+  }
+  float const penetration_y = half_height [lhs] + half_height [rhs] - overlap - std::abs (distance_y);
+  if (penetration_y <= 0.f)
+  {
+    return;
+  }
+
+  // Resolve along the axis with the smallest penetration, i.e. the side the tiles hit each other on.
+  // Position response: each tile moves half of the way out.
+  // Velocity response: same as hitting a wall, a tile moving towards the other has that axis of its velocity reflected.
+  // This is elastic (no energy is lost) and keeps every tile moving at { TILE_SPEED_MOVEMENT }.
+  if (penetration_x < penetration_y)
+  {
+    float const direction = distance_x < 0.f ? -1.f : 1.f; // lhs -> rhs
+    pos_x [lhs] -= direction * penetration_x / 2.f;
+    pos_x [rhs] += direction * penetration_x / 2.f;
+
+    if (vel_x [lhs] * direction > 0.f)
+    {
+      vel_x [lhs] = -vel_x [lhs];
+    }
+    if (vel_x [rhs] * direction < 0.f)
+    {
+      vel_x [rhs] = -vel_x [rhs];
+    }
+  }
+  else
+  {
+    float const direction = distance_y < 0.f ? -1.f : 1.f;
+    pos_y [lhs] -= direction * penetration_y / 2.f;
+    pos_y [rhs] += direction * penetration_y / 2.f;
+
+    if (vel_y [lhs] * direction > 0.f)
+    {
+      vel_y [lhs] = -vel_y [lhs];
+    }
+    if (vel_y [rhs] * direction < 0.f)
+    {
+      vel_y [rhs] = -vel_y [rhs];
+    }
+  }
+}
+
+
+
+eat_query_t get_eat_query (players_t const& players, unsigned player, sprite_table_t const& sprites)
+{
+  sprite_metrics_t const& player_size = get_sprite_metrics (sprites, get_column <player_state_t> (players) [player]);
+  sprite_metrics_t const& tile_normal = get_sprite_metrics (sprites, SPRITE_ID_TILE_NORMAL);
+  sprite_metrics_t const& tile_wide = get_sprite_metrics (sprites, SPRITE_ID_TILE_WIDE);
+  float const overlap = COLLISION_OVERLAP;
+
+  eat_query_t query;
+  query.player_x = (float)get_column <player_position_x_t> (players) [player];
+  query.player_y = (float)get_column <player_position_y_t> (players) [player];
+  query.reach_x_normal = (player_size.width  - overlap) / 2.f + (tile_normal.width  - overlap) / 2.f;
+  query.reach_y_normal = (player_size.height - overlap) / 2.f + (tile_normal.height - overlap) / 2.f;
+  query.reach_x_wide   = (player_size.width  - overlap) / 2.f + (tile_wide.width    - overlap) / 2.f;
+  query.reach_y_wide   = (player_size.height - overlap) / 2.f + (tile_wide.height   - overlap) / 2.f;
+  return query;
+}
 
-void resolve_collisions (magpie::spritesheet spritesheet, magpie::renderer const& renderer,
-  player_t& p,
+arena_query_t get_arena_query (walls_t const& walls, sprite_table_t const& sprites)
+{
+  arena_query_t query;
+  auto const wall_size = get_column <wall_size_t> (walls);
+  auto const wall_x = get_column <wall_position_x_t> (walls);
+  auto const wall_y = get_column <wall_position_y_t> (walls);
+  auto const wall_id = get_column <wall_object_id_t> (walls);
+  for (unsigned rhs = 0; rhs < walls.count; rhs++)
+  {
+    switch (wall_id [rhs])
+    {
+      case WALL_ID_LEFT:   query.left   = (float)(wall_x [rhs] + wall_size [rhs] / 2.0); break;
+      case WALL_ID_RIGHT:  query.right  = (float)(wall_x [rhs] - wall_size [rhs] / 2.0); break;
+      case WALL_ID_TOP:    query.top    = (float)(wall_y [rhs] - wall_size [rhs] / 2.0); break;
+      case WALL_ID_BOTTOM: query.bottom = (float)(wall_y [rhs] + wall_size [rhs] / 2.0); break;
+      default: break;
+    }
+  }
+  query.half_width_normal  = get_sprite_metrics (sprites, SPRITE_ID_TILE_NORMAL).half_width;
+  query.half_height_normal = get_sprite_metrics (sprites, SPRITE_ID_TILE_NORMAL).half_height;
+  query.half_width_wide    = get_sprite_metrics (sprites, SPRITE_ID_TILE_WIDE).half_width;
+  query.half_height_wide   = get_sprite_metrics (sprites, SPRITE_ID_TILE_WIDE).half_height;
+  query.overlap = COLLISION_OVERLAP;
+  return query;
+}
+
+
+void resolve_collisions (sprite_table_t const& sprites,
+  players_t& players,
   tiles_t& tiles,
-  walls_t& walls)
+  walls_t& walls,
+  frame_arena_t& arena,
+  job_system_t& jobs)
 {
   // lhs = left hand side
   // rhs = right hand side
@@ -97,22 +258,43 @@ void resolve_collisions (magpie::spritesheet spritesheet, magpie::renderer const
   //  }
   //}
 
-
-  // PLAYER v WALL
+  // PLAYER v TILE (SIMD)
+  //
+  // Same strategy as above, but every tile is tested against the player 4/8/16 at a time (see eat_tiles),
+  // with the tiles split between the job system's threads.
+  // The kernel marks tiles as eaten itself, and lists which ones it ate,
+  // so the player only hears about the few tiles it actually touched.
+  for (unsigned lhs = 0; lhs < players.count; lhs++)
   {
-    player_t* lhs = &p;
-    for (auto rhs_it = walls.data.begin (); rhs_it != walls.data.end (); rhs_it++)
+    unsigned const num_eaten = eat_tiles (tiles, get_eat_query (players, lhs, sprites), arena, jobs);
+    for (unsigned i = 0; i < num_eaten; i++)
     {
-      wall_t* rhs = &(*rhs_it);
+      unsigned const rhs = tiles.eaten_indices [i];
+      collision_handler_t <PLAYER_TYPE, TILE_TYPE>::on_collision (players, lhs, get_column <tile_object_id_t> (tiles) [rhs]);
+    }
+  }
 
-      // get size of player via their spritesheet size
-      texture_rect const* lhs_rect = get_player_texture_rect (spritesheet, lhs->get_id ());
 
-      if (is_overlapping ((float)lhs->position.x,(float) lhs->position.y, (float)lhs_rect->width, (float)lhs_rect->height,
-        (float)rhs->position.x, (float)rhs->position.y, (float)rhs->size, (float)rhs->size))
+  // PLAYER v WALL
+  {
+    auto const player_x = get_column <player_position_x_t> (players);
+    auto const player_y = get_column <player_position_y_t> (players);
+    auto const wall_size = get_column <wall_size_t> (walls);
+    auto const wall_x = get_column <wall_position_x_t> (walls);
+    auto const wall_y = get_column <wall_position_y_t> (walls);
+    for (unsigned lhs = 0; lhs < players.count; lhs++)
+    {
+      for (unsigned rhs = 0; rhs < walls.count; rhs++)
       {
-        lhs->on_collision (WALL_TYPE,   (void*)rhs, spritesheet);
-        rhs->on_collision (PLAYER_TYPE, (void*)lhs, spritesheet, -1);
+        // get size of player via their spritesheet size
+        sprite_metrics_t const& lhs_size = get_sprite_metrics (sprites, get_column <player_state_t> (players) [lhs]);
+
+        if (is_overlapping ((float)player_x [lhs], (float)player_y [lhs], lhs_size.width, lhs_size.height,
+          (float)wall_x [rhs], (float)wall_y [rhs], (float)wall_size [rhs], (float)wall_size [rhs]))
+        {
+          collision_handler_t <PLAYER_TYPE, WALL_TYPE>::on_collision (players, lhs, walls, rhs, sprites);
+          collision_handler_t <WALL_TYPE, PLAYER_TYPE>::on_collision (walls, rhs, players, lhs);
+        }
       }
     }
   }
@@ -136,6 +318,8 @@ void resolve_collisions (magpie::spritesheet spritesheet, magpie::renderer const
   /// Want to attempt to optimise that algorithm??
   /// Andy is going to introduce you to algorithms that help
   /// reduce the amount of work needed to detect collisions.
+  ///
+  /// See resolve_tile_collisions below, which use a spatial grid or sweep and prune to only check nearby tiles.
 
 
   //TILE v WALL (IMPROVEMENT)
@@ -156,33 +340,81 @@ void resolve_collisions (magpie::spritesheet spritesheet, magpie::renderer const
 //        }
 //    }
 //}
- // TILE v WALL
-//for (auto lhs_it = tiles.data.begin (); lhs_it != tiles.data.end (); lhs_it++) //checks lhs of wall and tile
-//{
-//  tile_t* lhs = (*lhs_it).second;
-//  if (lhs != nullptr)
-  for (int i = 0; i < NUM_TILES; i++)
-  {
 
-    // get size of tile via their spritesheet size
-    texture_rect const* lhs_rect = get_tile_texture_rect (spritesheet, tiles.tile_id[i]);
+  // TILE v WALL (SIMD)
+  //
+  // Every tile against every wall used to be 4 is_overlapping calls per tile,
+  // then on_collision comparing the wall's id to work out which way to push.
+  // The walls never move and are far bigger than the screen, so all that matters is where their inside faces are.
+  // Those 4 numbers are found once (see get_arena_query), then every tile is clamped and reflected against them at once (see bounce_tiles).
+  bounce_tiles (tiles, get_arena_query (walls, sprites), jobs);
+}
 
-    for (auto rhs_it = walls.data.begin (); rhs_it != walls.data.end (); rhs_it++) 
+
+  // Hint: that is a lot of getting object texture_rects...
+  // Do we really need all that info?
+  // Plus, how do we get that texture_rect? Is the underlying function quick?
+
+
+void resolve_tile_collisions (tiles_t& tiles, spatial_grid_t const& grid)
+{
+  // Each cell is checked against itself and 4 of its neighbours:
+  //
+  //   +---+---+---+
+  //   | x | x | x |
+  //   +---+---+---+
+  //   |   | c | x |
+  //   +---+---+---+
+  //   |   |   |   |
+  //   +---+---+---+
+  //
+  // The other 4 neighbours check against this cell when it is their turn,
+  // so every pair of tiles is only tested once.
+  int const neighbour_offsets [4][2] = { { 1, 0 }, { -1, 1 }, { 0, 1 }, { 1, 1 } };
+
+  for (unsigned cell_y = 0; cell_y < grid.cells_y; cell_y++)
+  {
+    for (unsigned cell_x = 0; cell_x < grid.cells_x; cell_x++)
     {
-      wall_t* rhs = &(*rhs_it);
+      unsigned const cell = cell_y * grid.cells_x + cell_x;
+      unsigned const cell_begin = grid.cell_start [cell];
+      unsigned const cell_end = grid.cell_start [cell + 1u];
 
-      if (is_overlapping ((float)tiles.pos_x[i], (float)tiles.pos_y[i], (float)lhs_rect->width, (float)lhs_rect->height,
-        (float)rhs->position.x, (float)rhs->position.y, (float)rhs->size, (float)rhs->size))
+      for (unsigned lhs_it = cell_begin; lhs_it < cell_end; lhs_it++)
       {
-        tiles.on_collision (WALL_TYPE, (void*)rhs, spritesheet, i);
-        rhs->on_collision (TILE_TYPE, (void*)&tiles, spritesheet, i);
+        unsigned const lhs = grid.sorted_tiles [lhs_it];
+
+        // same cell, only tiles after this one
+        for (unsigned rhs_it = lhs_it + 1u; rhs_it < cell_end; rhs_it++)
+        {
+          collision_resolve_tile_tile (tiles, grid.half_width, grid.half_height, lhs, grid.sorted_tiles [rhs_it]);
+        }
+
+        // neighbouring cells
+        for (auto const& offset : neighbour_offsets)
+        {
+          int const other_x = (int)cell_x + offset [0];
+          int const other_y = (int)cell_y + offset [1];
+          if (other_x < 0 || other_x >= (int)grid.cells_x || other_y >= (int)grid.cells_y)
+          {
+            continue;
+          }
+
+          unsigned const other = (unsigned)other_y * grid.cells_x + (unsigned)other_x;
+          for (unsigned rhs_it = grid.cell_start [other]; rhs_it < grid.cell_start [other + 1u]; rhs_it++)
+          {
+            collision_resolve_tile_tile (tiles, grid.half_width, grid.half_height, lhs, grid.sorted_tiles [rhs_it]);
+          }
+        }
       }
     }
   }
 }
 
-
-  // Hint: that is a lot of getting object texture_rects...
-  // Do we really need all that info?
-  // Plus, how do we get that texture_rect? Is the underlying function quick?
-
+void resolve_tile_collisions (tiles_t& tiles, sweep_and_prune_t const& sap)
+{
+  for (sap_pair_t const& pair : sap.tile_pairs)
+  {
+    collision_resolve_tile_tile (tiles, sap.half_width, sap.half_height, pair.lhs, pair.rhs);
+  }
+}
@@ -1,13 +1,91 @@
 #pragma once
 
-#include "magpie.h"  // for magpie::spritesheet, magpie::renderer
+#include "constants.h" // for object_type_t, object_id_t
+#include "sprites.h"   // for sprite_table_t
 
 
-class player_t; // forward declare
+struct players_t; // forward declare
 struct tiles_t;
 struct walls_t;
+struct spatial_grid_t;
+struct sweep_and_prune_t;
+struct job_system_t;
+struct frame_arena_t;
+struct eat_query_t;
+struct arena_query_t;
 
-void resolve_collisions (magpie::spritesheet spritesheet, magpie::renderer const& renderer,
-  player_t& p,
+
+/// <summary>
+/// objects are allowed to overlap by this amount before they count as colliding
+/// </summary>
+float const COLLISION_OVERLAP = 4.f;
+
+
+// COLLISION HANDLERS
+//
+// collision_handler_t <LHS, RHS>::on_collision is what happens to an object of type LHS when it hits an object of type RHS.
+// The table is filled in at compile time, one specialisation per pair of types that does something.
+// resolve_collisions always knows which pair of types it is testing, so the right handler is picked by the compiler,
+// nothing checks an object's type at run time.
+//
+// Tiles don't appear on the lhs, they are resolved all at once by the tile kernels (see eat_tiles, bounce_tiles).
+
+template <object_type_t LHS, object_type_t RHS>
+struct collision_handler_t
+{
+  // any other pair: nothing happens, e.g. a wall doesn't care what hits it
+  template <typename... args_t>
+  static void on_collision (args_t const&...) {}
+};
+
+template <>
+struct collision_handler_t <PLAYER_TYPE, TILE_TYPE>
+{
+  /// <summary>
+  /// player { player } has eaten a tile
+  /// </summary>
+  static void on_collision (players_t& players, unsigned player, object_id_t tile_id);
+};
+
+template <>
+struct collision_handler_t <PLAYER_TYPE, WALL_TYPE>
+{
+  /// <summary>
+  /// player { player } has walked into wall { wall }, push it back out
+  /// </summary>
+  static void on_collision (players_t& players, unsigned player, walls_t const& walls, unsigned wall,
+    sprite_table_t const& sprites);
+};
+
+
+/// <summary>
+/// PLAYER v TILE
+/// player { player }'s AABB, and how close each type of tile has to get to it, for eat_tiles
+/// </summary>
+eat_query_t get_eat_query (players_t const& players, unsigned player, sprite_table_t const& sprites);
+
+/// <summary>
+/// TILE v WALL
+/// the inside faces of { walls }, and the size of each type of tile, for bounce_tiles
+/// </summary>
+arena_query_t get_arena_query (walls_t const& walls, sprite_table_t const& sprites);
+
+
+void resolve_collisions (sprite_table_t const& sprites,
+  players_t& players,
   tiles_t& tiles,
-  walls_t& walls);
+  walls_t& walls,
+  frame_arena_t& arena,
+  job_system_t& jobs);
+
+/// <summary>
+/// TILE v TILE
+/// resolve every overlapping pair of tiles, using a grid built this frame to find them
+/// </summary>
+void resolve_tile_collisions (tiles_t& tiles, spatial_grid_t const& grid);
+
+/// <summary>
+/// TILE v TILE
+/// resolve every overlapping pair of tiles found by the last sweep and prune update
+/// </summary>
+void resolve_tile_collisions (tiles_t& tiles, sweep_and_prune_t const& sap);
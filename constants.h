@@ -1,8 +1,6 @@
 #pragma once
 
-#include "magpie.h" // for magpie::maths::two_pi <...> ()
-
-#include <string>   // for std::string
+#include <cstdint> // for std::uint8_t
 
 
 ////////////////////////////////
@@ -22,6 +20,11 @@ unsigned const SCREEN_HEIGHT = 720u;
 // Their type though is up for debate...
 
 
+// maths
+// (kept here rather than using magpie::maths::two_pi so the simulation builds without Magpie)
+double const TWO_PI = 6.283185307179586476925;
+
+
 // player
 double const PLAYER_SPEED = 300.0;
 // How long, in seconds, the player becomes a 'wide' for before reverting back to a 'normal' player.
@@ -42,7 +45,7 @@ unsigned const NUM_TILES = 1u << 10;
 
 double const TILE_SPEED_MOVEMENT = 100.0;
 // Rotation speed of all tile types, in radians.
-double const TILE_SPEED_ROTATION = magpie::maths::two_pi <double> () * 2.0;
+double const TILE_SPEED_ROTATION = TWO_PI * 2.0;
 // How long, in seconds, a 'wide' tile lives before expiring.
 double const TILE_WIDE_LIFETIIME = 15.0;
 // Percentage chance of a 'wide' tile spawning.
@@ -55,26 +58,45 @@ double const PROBABILITY_WIDE = 0.2;
 
 
 // object types
-using object_type_t = std::string;
-object_type_t const PLAYER_TYPE ("player");
-object_type_t const TILE_TYPE ("tile");
-object_type_t const WALL_TYPE ("wall");
-
-
-using object_id_t = std::string;
-
-// player
-object_id_t const PLAYER_ID_NORMAL ("player_normal");
-object_id_t const PLAYER_ID_WIDE ("player_wide");
-
-
-// tiles
-object_id_t const TILE_ID_NORMAL ("tile_normal");
-object_id_t const TILE_ID_WIDE ("tile_wide");
-
-
-// walls
-object_id_t const WALL_ID_LEFT ("wall_left");
-object_id_t const WALL_ID_RIGHT ("wall_right");
-object_id_t const WALL_ID_TOP ("wall_top");
-object_id_t const WALL_ID_BOTTOM ("wall_bottom");
+// 1 byte tags rather than strings: cheap to copy and compare, and small enough to sit in the SoA arrays next to the floats
+enum object_type_t : std::uint8_t
+{
+  PLAYER_TYPE,
+  TILE_TYPE,
+  WALL_TYPE,
+
+  NUM_OBJECT_TYPES,
+};
+
+
+enum object_id_t : std::uint8_t
+{
+  // player
+  PLAYER_ID_NORMAL,
+  PLAYER_ID_WIDE,
+
+  // tiles
+  TILE_ID_NORMAL,
+  TILE_ID_WIDE,
+
+  // walls
+  WALL_ID_LEFT,
+  WALL_ID_RIGHT,
+  WALL_ID_TOP,
+  WALL_ID_BOTTOM,
+
+  NUM_OBJECT_IDS,
+
+  // not an object, e.g. the player isn't about to change into anything
+  OBJECT_ID_NONE = NUM_OBJECT_IDS,
+};
+
+
+// names, for debug printing only, indexed by the tags above
+char const* const OBJECT_TYPE_NAMES [NUM_OBJECT_TYPES] = { "player", "tile", "wall" };
+char const* const OBJECT_ID_NAMES [NUM_OBJECT_IDS] =
+{
+  "player_normal", "player_wide",
+  "tile_normal", "tile_wide",
+  "wall_left", "wall_right", "wall_top", "wall_bottom",
+};
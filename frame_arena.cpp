@@ -0,0 +1,82 @@
+#include "frame_arena.h"
+
+#include "utility.h" // for aligned_allocate, aligned_release, CACHE_LINE_SIZE
+
+#include <algorithm> // for std::max
+
+
+/// <summary>
+/// { bytes } rounded up to a whole number of cache lines
+/// </summary>
+static std::size_t round_to_cache_lines (std::size_t bytes)
+{
+  return (bytes + CACHE_LINE_SIZE - 1u) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+}
+
+/// <summary>
+/// free every overflow block
+/// </summary>
+static void release_overflow (frame_arena_t& arena)
+{
+  while (arena.overflow != nullptr)
+  {
+    frame_arena_overflow_t* const next = arena.overflow->next;
+    aligned_release (arena.overflow);
+    arena.overflow = next;
+  }
+}
+
+
+void initialise_frame_arena (frame_arena_t& arena, std::size_t capacity)
+{
+  arena.capacity = round_to_cache_lines (capacity);
+  arena.memory = arena.capacity > 0u ? (unsigned char*)aligned_allocate (arena.capacity) : nullptr;
+  arena.used = 0;
+  arena.peak = 0;
+  arena.overflow = nullptr;
+}
+
+void release_frame_arena (frame_arena_t& arena)
+{
+  release_overflow (arena);
+  aligned_release (arena.memory);
+  arena = {};
+}
+
+void* frame_allocate (frame_arena_t& arena, std::size_t bytes)
+{
+  // every allocation is a whole number of cache lines, so the next one starts on a cache line too,
+  // and 2 lists filled in by different threads never share one
+  bytes = round_to_cache_lines (bytes);
+
+  std::size_t const offset = arena.used;
+  arena.used += bytes;
+  if (arena.used <= arena.capacity)
+  {
+    return arena.memory + offset;
+  }
+
+  // Out of room, only until the next reset regrows the block.
+  // The header takes a whole cache line so the memory after it stays aligned.
+  unsigned char* const block = (unsigned char*)aligned_allocate (CACHE_LINE_SIZE + bytes);
+  frame_arena_overflow_t* const overflow = (frame_arena_overflow_t*)block;
+  overflow->next = arena.overflow;
+  arena.overflow = overflow;
+  return block + CACHE_LINE_SIZE;
+}
+
+void reset_frame_arena (frame_arena_t& arena)
+{
+  arena.peak = std::max (arena.peak, arena.used);
+  arena.used = 0;
+
+  if (arena.overflow != nullptr)
+  {
+    release_overflow (arena);
+
+    // one block big enough for the worst step so far, so the same step again won't overflow
+    aligned_release (arena.memory);
+    arena.capacity = arena.peak;
+    arena.memory = (unsigned char*)aligned_allocate (arena.capacity);
+  }
+}
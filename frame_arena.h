@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef> // for std::size_t
+
+
+// FRAME ARENA
+//
+// A bump allocator for scratch memory that only lives for one step of the game loop,
+// e.g. the tiles eaten this step, or the tiles being respawned and their random numbers.
+// Allocating moves a cursor along one block, and reset_frame_arena drops everything at once by moving it back,
+// so a step's scratch costs no calls to the global heap and nothing is ever freed one piece at a time.
+//
+// If a step needs more than the block holds, the rest comes from overflow blocks off the heap.
+// The next reset frees those and regrows the block to the most any step has needed so far (the peak),
+// so after the first few steps the arena has settled and steady state steps never touch the heap.
+//
+// Only the thread that owns the arena allocates from it, e.g. before a parallel_for rather than inside one.
+
+
+/// <summary>
+/// a block from the heap, used when the arena's own block is full
+/// </summary>
+struct frame_arena_overflow_t
+{
+  frame_arena_overflow_t* next;
+};
+
+
+struct frame_arena_t
+{
+  unsigned char* memory; // aligned to a cache line
+  std::size_t capacity;  // bytes in { memory }
+  std::size_t used;      // bytes handed out since the last reset, overflow included
+
+  // the most bytes handed out between 2 resets, the arena's watermark
+  // once the arena has settled this is how big its block needs to be
+  std::size_t peak;
+
+  frame_arena_overflow_t* overflow; // overflow blocks since the last reset, newest first
+};
+
+
+/// <summary>
+/// pre game loop set up code
+/// { capacity } bytes to start with, the arena grows to fit its peak as needed
+/// </summary>
+void initialise_frame_arena (frame_arena_t& arena, std::size_t capacity);
+
+/// <summary>
+/// post game loop tear down code
+/// everything allocated from the arena goes with it
+/// </summary>
+void release_frame_arena (frame_arena_t& arena);
+
+/// <summary>
+/// { bytes } of scratch memory aligned to a cache line, NOT initialised
+/// only valid until the next reset_frame_arena
+/// </summary>
+void* frame_allocate (frame_arena_t& arena, std::size_t bytes);
+
+/// <summary>
+/// scratch array of { count } { T }s, see frame_allocate
+/// </summary>
+template <typename T>
+T* frame_allocate_array (frame_arena_t& arena, std::size_t count)
+{
+  return (T*)frame_allocate (arena, count * sizeof (T));
+}
+
+/// <summary>
+/// end of the step, drop everything allocated from the arena
+/// updates the peak, and if the block overflowed this step, regrows it to fit the peak
+/// </summary>
+void reset_frame_arena (frame_arena_t& arena);
@@ -0,0 +1,120 @@
+#include "frame_pipeline.h"
+
+#include "frame_stats.h" // for get_clock_nanoseconds
+#include "profiler.h"    // for PROFILE_ZONE, PROFILE_THREAD_NAME
+#include "simulation.h"  // for simulation_t
+#include "tiles.h"       // for tiles_t
+#include "utility.h"     // for aligned_allocate, aligned_release
+
+#include <cstring>       // for std::memcpy
+
+
+/// <summary>
+/// copy out everything the renderer needs from the simulation's current state
+/// </summary>
+static void take_snapshot (frame_snapshot_t& frame, simulation_t& simulation)
+{
+  PROFILE_ZONE ("render prep");
+
+  // between the last 2 steps, see simulation_t::get_interpolation
+  double const interpolation = simulation.get_interpolation ();
+
+  vector4 const now = get_player_position (simulation.players, USER_PLAYER);
+  vector4 const prev = get_player_prev_position (simulation.players, USER_PLAYER);
+  frame.player_position = now;
+  frame.player_position.x += (prev.x - now.x) * (1.0 - interpolation);
+  frame.player_position.y += (prev.y - now.y) * (1.0 - interpolation);
+  frame.player_id = get_column <player_state_t> (simulation.players) [USER_PLAYER];
+
+  frame.num_tiles = simulation.tiles.count;
+  std::memcpy (frame.tile_id, get_column <tile_object_id_t> (simulation.tiles).data, simulation.tiles.count * sizeof (object_id_t));
+  build_tile_transforms (frame.tile_transforms, simulation.tiles, simulation.config.sprites,
+    (float)interpolation, simulation.jobs);
+}
+
+
+static void sim_thread_main (frame_pipeline_t* pipeline)
+{
+  PROFILE_THREAD_NAME ("sim");
+
+  for (;;)
+  {
+    frame_request_t const request = begin_read (pipeline->requests);
+    end_read (pipeline->requests);
+
+    if (request.quit)
+    {
+      return;
+    }
+
+    std::uint64_t const advance_start = get_clock_nanoseconds ();
+    pipeline->simulation->advance (request.elapsed, request.input);
+    std::uint64_t const advance_end = get_clock_nanoseconds ();
+
+    frame_snapshot_t& frame = begin_write (pipeline->frames);
+    take_snapshot (frame, *pipeline->simulation);
+    frame.advance_nanoseconds = advance_end - advance_start;
+    frame.render_prep_nanoseconds = get_clock_nanoseconds () - advance_end;
+    end_write (pipeline->frames);
+  }
+}
+
+
+void initialise_frame_pipeline (frame_pipeline_t& pipeline, simulation_t& simulation)
+{
+  pipeline.simulation = &simulation;
+
+  for (frame_snapshot_t& frame : pipeline.frames.slots)
+  {
+    frame.num_tiles = 0;
+    frame.tile_id = (object_id_t*)aligned_allocate (simulation.tiles.capacity * sizeof (object_id_t));
+    initialise_tile_transforms (frame.tile_transforms, simulation.tiles.capacity);
+  }
+
+  // the first frame is the simulation as it starts
+  frame_snapshot_t& first = begin_write (pipeline.frames);
+  take_snapshot (first, simulation);
+  first.advance_nanoseconds = 0;
+  first.render_prep_nanoseconds = 0;
+  end_write (pipeline.frames);
+
+  pipeline.sim_thread = std::thread (sim_thread_main, &pipeline);
+}
+
+frame_snapshot_t const& begin_frame (frame_pipeline_t& pipeline)
+{
+  return begin_read (pipeline.frames);
+}
+
+void request_step (frame_pipeline_t& pipeline, double elapsed, player_input_t input)
+{
+  frame_request_t& request = begin_write (pipeline.requests);
+  request.elapsed = elapsed;
+  request.input = input;
+  request.quit = false;
+  end_write (pipeline.requests);
+}
+
+void end_frame (frame_pipeline_t& pipeline)
+{
+  end_read (pipeline.frames);
+}
+
+void release_frame_pipeline (frame_pipeline_t& pipeline)
+{
+  // The render thread only ever asks for one step ahead of what it is drawing,
+  // so there is always a free snapshot for that step to go in, and the sim thread gets to the quit without blocking.
+  frame_request_t& request = begin_write (pipeline.requests);
+  request.quit = true;
+  end_write (pipeline.requests);
+
+  pipeline.sim_thread.join ();
+
+  for (frame_snapshot_t& frame : pipeline.frames.slots)
+  {
+    aligned_release (frame.tile_id);
+    release_tile_transforms (frame.tile_transforms);
+    frame = {};
+  }
+  pipeline.simulation = nullptr;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "constants.h"       // for object_id_t
+#include "player.h"          // for player_input_t
+#include "spsc_ring.h"       // for spsc_ring_t
+#include "tile_transforms.h" // for tile_transforms_t
+#include "utility.h"         // for vector4
+
+#include <cstdint>           // for std::uint64_t
+#include <thread>            // for std::thread
+
+
+struct simulation_t; // forward declare
+
+
+// FRAME PIPELINE
+//
+// Runs the simulation on its own thread, one frame ahead of the renderer:
+//
+//   render thread: | draw frame N      | draw frame N+1    | draw frame N+2    |
+//   sim thread:    | advance frame N+1 | advance frame N+2 | advance frame N+3 |
+//
+// After each frame's steps the sim thread copies out everything drawing needs into a frame_snapshot_t,
+// including the tile transforms, so the render thread never touches the simulation while it is stepping.
+// There are 2 snapshots, the one being drawn and the one being filled in. They are handed back and forth
+// through an spsc_ring_t, and the render thread's step requests go the other way through another one.
+//
+// Every frame is still advanced once, in order, with the elapsed time and input it was asked for,
+// so the simulation ends up exactly where it would have without the pipeline.
+// What is on screen is one frame behind the input that was just polled.
+// The snapshot's positions are interpolated between the last 2 fixed steps (see simulation.h).
+
+
+/// <summary>
+/// one frame of the simulation, as much of it as the renderer needs
+/// the walls are left out, they never move, the renderer can draw simulation.walls at any time
+/// </summary>
+struct frame_snapshot_t
+{
+  vector4 player_position; // interpolated, like the tile transforms
+  object_id_t player_id;
+
+  unsigned num_tiles;
+  object_id_t* tile_id;
+  tile_transforms_t tile_transforms;
+
+  // how long the sim thread took to make this frame, for the render thread's frame stats (see frame_stats.h)
+  // 0 for the first frame, which is taken before the sim thread starts
+  std::uint64_t advance_nanoseconds;
+  std::uint64_t render_prep_nanoseconds;
+};
+
+
+/// <summary>
+/// what the render thread wants the sim thread to do next
+/// </summary>
+struct frame_request_t
+{
+  double elapsed;
+  player_input_t input;
+  bool quit;
+};
+
+
+struct frame_pipeline_t
+{
+  simulation_t* simulation;
+  std::thread sim_thread;
+
+  spsc_ring_t <frame_request_t, 4> requests; // render -> sim
+  spsc_ring_t <frame_snapshot_t, 2> frames;  // sim -> render
+};
+
+
+/// <summary>
+/// pre game loop set up code
+/// takes a snapshot of the simulation as it is now, for the first frame, then starts the sim thread
+/// from here on only the sim thread may touch { simulation }, until release_frame_pipeline
+/// </summary>
+void initialise_frame_pipeline (frame_pipeline_t& pipeline, simulation_t& simulation);
+
+/// <summary>
+/// render thread: the oldest frame that hasn't been drawn yet, waits for the sim thread to finish it if need be
+/// call end_frame once it has been drawn
+/// </summary>
+frame_snapshot_t const& begin_frame (frame_pipeline_t& pipeline);
+
+/// <summary>
+/// render thread: advance the simulation by another frame, on the sim thread (see simulation_t::advance)
+/// call straight after begin_frame, so the steps run while that frame is being drawn
+/// </summary>
+void request_step (frame_pipeline_t& pipeline, double elapsed, player_input_t input);
+
+/// <summary>
+/// render thread: done drawing the frame from begin_frame, the sim thread can fill it in again
+/// </summary>
+void end_frame (frame_pipeline_t& pipeline);
+
+/// <summary>
+/// post game loop tear down code
+/// finishes any steps still waiting and stops the sim thread, after which the simulation is the caller's again
+/// </summary>
+void release_frame_pipeline (frame_pipeline_t& pipeline);
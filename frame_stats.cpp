@@ -0,0 +1,174 @@
+#include "frame_stats.h"
+
+#include <algorithm> // for std::max, std::min
+#include <bit>       // for std::bit_width
+#include <cmath>     // for std::ceil
+#include <cstring>   // for std::memset
+
+
+// names, for printing only, indexed by frame_phase_t
+static char const* const FRAME_PHASE_NAMES [NUM_FRAME_PHASES] =
+{
+  "frame", "advance", "render prep", "submit",
+};
+
+
+// HISTOGRAM
+//
+// Times under 2^SUB_BITS ns get a bucket each.
+// Above that, a time whose top bit is bit { msb } keeps its top SUB_BITS + 1 bits and drops the { msb - SUB_BITS } below,
+// so each power of 2 is split into 2^SUB_BITS equal buckets, each at most 1 / 2^SUB_BITS of the times in it.
+
+static unsigned get_bucket (std::uint64_t nanoseconds)
+{
+  unsigned const sub_buckets = 1u << FRAME_HISTOGRAM_SUB_BITS;
+  if (nanoseconds < sub_buckets)
+  {
+    return (unsigned)nanoseconds;
+  }
+
+  unsigned const msb = (unsigned)std::bit_width (nanoseconds) - 1u;
+  if (msb >= FRAME_HISTOGRAM_MAX_BITS)
+  {
+    return FRAME_HISTOGRAM_BUCKETS - 1u;
+  }
+
+  unsigned const shift = msb - FRAME_HISTOGRAM_SUB_BITS;
+  unsigned const mantissa = (unsigned)(nanoseconds >> shift); // [sub_buckets, 2 * sub_buckets)
+  return ((shift + 1u) << FRAME_HISTOGRAM_SUB_BITS) + (mantissa - sub_buckets);
+}
+
+/// <summary>
+/// the longest time that lands in { bucket }
+/// </summary>
+static std::uint64_t get_bucket_highest (unsigned bucket)
+{
+  unsigned const sub_buckets = 1u << FRAME_HISTOGRAM_SUB_BITS;
+  if (bucket < sub_buckets)
+  {
+    return bucket;
+  }
+
+  unsigned const shift = (bucket >> FRAME_HISTOGRAM_SUB_BITS) - 1u;
+  std::uint64_t const mantissa = (bucket & (sub_buckets - 1u)) + sub_buckets;
+  return ((mantissa + 1u) << shift) - 1u;
+}
+
+
+// CLOCK
+
+std::uint64_t get_clock_nanoseconds ()
+{
+  return (std::uint64_t)std::chrono::duration_cast <std::chrono::nanoseconds> (
+    std::chrono::steady_clock::now ().time_since_epoch ()).count ();
+}
+
+void initialise_frame_clock (frame_clock_t& clock)
+{
+  clock.last_tick = std::chrono::steady_clock::now ();
+}
+
+std::uint64_t tick_frame_clock (frame_clock_t& clock)
+{
+  std::chrono::steady_clock::time_point const now = std::chrono::steady_clock::now ();
+  std::uint64_t const elapsed = (std::uint64_t)std::chrono::duration_cast <std::chrono::nanoseconds> (now - clock.last_tick).count ();
+  clock.last_tick = now;
+  return elapsed;
+}
+
+
+// STATS
+
+void initialise_frame_stats (frame_stats_t& stats, unsigned window)
+{
+  for (frame_series_t& series : stats.phases)
+  {
+    series.samples = new std::uint64_t [window];
+    series.counts = new std::uint32_t [FRAME_HISTOGRAM_BUCKETS];
+    std::memset (series.counts, 0, FRAME_HISTOGRAM_BUCKETS * sizeof (std::uint32_t));
+    series.window = window;
+    series.num_samples = 0;
+    series.next = 0;
+  }
+}
+
+void release_frame_stats (frame_stats_t& stats)
+{
+  for (frame_series_t& series : stats.phases)
+  {
+    delete [] series.samples;
+    delete [] series.counts;
+    series = {};
+  }
+}
+
+void record_frame_phase (frame_stats_t& stats, frame_phase_t phase, std::uint64_t nanoseconds)
+{
+  frame_series_t& series = stats.phases [phase];
+
+  if (series.num_samples == series.window)
+  {
+    series.counts [get_bucket (series.samples [series.next])]--;
+  }
+  else
+  {
+    series.num_samples++;
+  }
+
+  series.samples [series.next] = nanoseconds;
+  series.counts [get_bucket (nanoseconds)]++;
+  series.next = series.next + 1u == series.window ? 0u : series.next + 1u;
+}
+
+std::uint64_t get_frame_max (frame_series_t const& series)
+{
+  std::uint64_t max = 0;
+  for (unsigned i = 0; i < series.num_samples; i++)
+  {
+    max = std::max (max, series.samples [i]);
+  }
+  return max;
+}
+
+std::uint64_t get_frame_percentile (frame_series_t const& series, double percentile)
+{
+  if (series.num_samples == 0u)
+  {
+    return 0;
+  }
+
+  // the sample at this rank (from 1) in sorted order
+  std::uint64_t const rank = std::max ((std::uint64_t)std::ceil (percentile * series.num_samples), (std::uint64_t)1u);
+
+  std::uint64_t seen = 0;
+  for (unsigned bucket = 0; bucket < FRAME_HISTOGRAM_BUCKETS; bucket++)
+  {
+    seen += series.counts [bucket];
+    if (seen >= rank)
+    {
+      return std::min (get_bucket_highest (bucket), get_frame_max (series));
+    }
+  }
+
+  return get_frame_max (series);
+}
+
+void print_frame_stats (std::FILE* file, frame_stats_t const& stats)
+{
+  std::fprintf (file, "%-12s %8s %9s %9s %9s %9s %9s (ms)\n", "phase", "samples", "p50", "p90", "p99", "p99.9", "max");
+  for (unsigned phase = 0; phase < NUM_FRAME_PHASES; phase++)
+  {
+    frame_series_t const& series = stats.phases [phase];
+    if (series.num_samples == 0u)
+    {
+      continue;
+    }
+
+    std::fprintf (file, "%-12s %8u %9.3f %9.3f %9.3f %9.3f %9.3f\n", FRAME_PHASE_NAMES [phase], series.num_samples,
+      get_frame_percentile (series, 0.5) / 1e6,
+      get_frame_percentile (series, 0.9) / 1e6,
+      get_frame_percentile (series, 0.99) / 1e6,
+      get_frame_percentile (series, 0.999) / 1e6,
+      get_frame_max (series) / 1e6);
+  }
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <chrono>  // for std::chrono::steady_clock
+#include <cstdint> // for std::uint32_t, std::uint64_t
+#include <cstdio>  // for std::FILE
+
+
+// FRAME STATS
+//
+// How long frames, and the phases within them, have been taking over the last { window } frames,
+// as percentiles (p50, p90, p99, p99.9) and the max, rather than the latest frame's time.
+// A game that averages 5ms but takes 40ms every few seconds stutters, only the tail shows that.
+//
+// Each phase keeps a histogram in the style of HdrHistogram: buckets are linear within each power of 2,
+// 2^FRAME_HISTOGRAM_SUB_BITS to a power, so every time from a microsecond to minutes is counted to within 1%
+// in a fixed few KB, and recording a time is a couple of shifts and an increment.
+// The window is a ring of the raw times, the oldest is taken back out of the histogram as each new one goes in.
+//
+// Nothing is printed while the game runs, print_frame_stats is called on demand or at exit.
+// Each frame_stats_t is only touched by one thread, times measured on other threads are handed to it
+// (e.g. the sim thread's, in the frame snapshot, see frame_pipeline.h).
+
+
+/// <summary>
+/// buckets per power of 2, as a power of 2, 7 = 128 buckets, so a bucket is at most 1/128th wide
+/// </summary>
+unsigned const FRAME_HISTOGRAM_SUB_BITS = 7u;
+
+/// <summary>
+/// times of 2^FRAME_HISTOGRAM_MAX_BITS nanoseconds (about 18 minutes) and over go in the last bucket
+/// </summary>
+unsigned const FRAME_HISTOGRAM_MAX_BITS = 40u;
+
+unsigned const FRAME_HISTOGRAM_BUCKETS = (FRAME_HISTOGRAM_MAX_BITS - FRAME_HISTOGRAM_SUB_BITS + 1u) << FRAME_HISTOGRAM_SUB_BITS;
+
+/// <summary>
+/// frames each phase's stats cover by default, about 17 seconds at 60 frames a second
+/// </summary>
+unsigned const FRAME_STATS_WINDOW = 1024u;
+
+
+/// <summary>
+/// the parts of a frame that are timed
+/// </summary>
+enum frame_phase_t : unsigned
+{
+  FRAME_PHASE_FRAME,       // the whole frame, one frame clock tick to the next
+  FRAME_PHASE_ADVANCE,     // stepping the simulation (see simulation_t::advance)
+  FRAME_PHASE_RENDER_PREP, // copying out what the renderer needs (see frame_snapshot_t)
+  FRAME_PHASE_SUBMIT,      // drawing and presenting
+
+  NUM_FRAME_PHASES,
+};
+
+
+/// <summary>
+/// one phase's last { window } times, and the histogram of them
+/// </summary>
+struct frame_series_t
+{
+  std::uint64_t* samples;  // ring of times, in nanoseconds
+  std::uint32_t* counts;   // { FRAME_HISTOGRAM_BUCKETS } counts
+  unsigned window;         // samples the ring holds
+  unsigned num_samples;    // samples in the ring, up to { window }
+  unsigned next;           // where the next sample goes
+};
+
+
+struct frame_stats_t
+{
+  frame_series_t phases [NUM_FRAME_PHASES];
+};
+
+
+/// <summary>
+/// a steady clock that ticks once a frame
+/// unlike the wall clock it never jumps, e.g. when the system time is set
+/// </summary>
+struct frame_clock_t
+{
+  std::chrono::steady_clock::time_point last_tick;
+};
+
+
+/// <summary>
+/// the steady clock, in nanoseconds, for timing phases: end - start
+/// </summary>
+std::uint64_t get_clock_nanoseconds ();
+
+/// <summary>
+/// start the clock, the first tick measures from here
+/// </summary>
+void initialise_frame_clock (frame_clock_t& clock);
+
+/// <summary>
+/// the time since the last tick (or initialise_frame_clock)
+/// </summary>
+/// <returns>nanoseconds</returns>
+std::uint64_t tick_frame_clock (frame_clock_t& clock);
+
+
+/// <summary>
+/// pre game loop set up code
+/// every phase covers its last { window } samples
+/// </summary>
+void initialise_frame_stats (frame_stats_t& stats, unsigned window = FRAME_STATS_WINDOW);
+
+/// <summary>
+/// post game loop tear down code
+/// </summary>
+void release_frame_stats (frame_stats_t& stats);
+
+/// <summary>
+/// add one time for { phase }, dropping its oldest if the window is full
+/// </summary>
+void record_frame_phase (frame_stats_t& stats, frame_phase_t phase, std::uint64_t nanoseconds);
+
+/// <summary>
+/// the time { percentile } (in [0, 1]) of the series' samples are at or under, to within a bucket (1%)
+/// never more than the series' max
+/// </summary>
+/// <returns>nanoseconds, 0 if there are no samples</returns>
+std::uint64_t get_frame_percentile (frame_series_t const& series, double percentile);
+
+/// <summary>
+/// the longest time in the series' window, exactly
+/// </summary>
+/// <returns>nanoseconds, 0 if there are no samples</returns>
+std::uint64_t get_frame_max (frame_series_t const& series);
+
+/// <summary>
+/// a table of p50, p90, p99, p99.9 and max for every phase with samples, in milliseconds
+/// </summary>
+void print_frame_stats (std::FILE* file, frame_stats_t const& stats);
@@ -0,0 +1,310 @@
+// HEADLESS
+//
+// Runs the simulation without a window, renderer or GPU.
+// usage: headless [--frames N] [--tiles N] [--elapsed SECONDS] [--broadphase none|grid|sap] [--spawn uniform|clustered]
+//        [--isa scalar|sse2|avx2|avx512] [--threads N]
+//        [--pipeline off|on] [--step-rate STEPS_PER_SECOND] [--seed N] [--trace PATH] [--stats-every N]
+//        [--record PATH] [--replay PATH] [--fixed-elapsed SECONDS] [--checksum-every N]
+// frame time percentiles over the last { FRAME_STATS_WINDOW } frames are printed at the end, and every N frames with --stats-every
+// --trace writes the profiling zones as a Chrome trace and prints where the time went, needs SHOT1_PROFILE (see profiler.h)
+// --elapsed is the frame time, the simulation runs as many fixed steps as fit in it (see simulation_t::advance)
+// --record writes the run to a replay file (see replay.h), --replay runs the frames and config in one instead,
+// with every frame { --fixed-elapsed } long if given, and the thread count and instruction set given here
+// the simulation's checksum is printed at the end, and every N frames with --checksum-every (not with --pipeline on,
+// the sim thread is still stepping), runs of the same replay should print the same checksums whatever their threads or kernels
+// e.g.   headless --frames 1000 --tiles 1000000
+
+
+#include "frame_pipeline.h" // for frame_pipeline_t
+#include "frame_stats.h"    // for frame_stats_t, frame_clock_t
+#include "profiler.h"       // for PROFILE_THREAD_NAME, write_profile_trace, print_profile_summary
+#include "replay.h"         // for replay_t, replay_recorder_t
+#include "simulation.h"     // for simulation_t
+#include "tile_kernels.h"   // for select_tile_kernels
+
+#include <chrono>           // for std::chrono::steady_clock
+#include <cstdio>           // for std::printf
+#include <cstdlib>          // for std::atoi, std::atof, std::strtoul, std::strtoull
+#include <cstring>          // for std::strcmp
+
+
+/// <summary>
+/// printed when the options can't be parsed
+/// </summary>
+char const* const HEADLESS_USAGE =
+  "usage: headless [--frames N] [--tiles N] [--elapsed SECONDS] [--broadphase none|grid|sap] [--spawn uniform|clustered]\n"
+  "                [--isa scalar|sse2|avx2|avx512] [--threads N]\n"
+  "                [--pipeline off|on] [--step-rate STEPS_PER_SECOND] [--seed N] [--trace PATH] [--stats-every N]\n"
+  "                [--record PATH] [--replay PATH] [--fixed-elapsed SECONDS] [--checksum-every N]\n";
+
+
+int main (int argc, char** argv)
+{
+  int frames = 1000;
+  double elapsed_secs = 1.0 / 60.0;
+  bool pipelined = false;
+  char const* trace_path = nullptr;
+  int stats_every = 0;
+  int checksum_every = 0;
+  char const* record_path = nullptr;
+  char const* replay_path = nullptr;
+  double fixed_elapsed_secs = 0.0;
+  simulation_config_t config = get_default_simulation_config ();
+
+  // every option takes a value, so the options come in pairs
+  if (argc % 2 == 0)
+  {
+    std::printf ("option '%s' needs a value\n%s", argv [argc - 1], HEADLESS_USAGE);
+    return 1;
+  }
+
+  for (int i = 1; i + 1 < argc; i += 2)
+  {
+    if (std::strcmp (argv [i], "--frames") == 0)
+    {
+      frames = std::atoi (argv [i + 1]);
+    }
+    else if (std::strcmp (argv [i], "--tiles") == 0)
+    {
+      config.num_tiles = (unsigned)std::strtoul (argv [i + 1], nullptr, 10);
+    }
+    else if (std::strcmp (argv [i], "--elapsed") == 0)
+    {
+      elapsed_secs = std::atof (argv [i + 1]);
+    }
+    else if (std::strcmp (argv [i], "--broadphase") == 0)
+    {
+      if (std::strcmp (argv [i + 1], "none") == 0)
+      {
+        config.tile_broadphase = tile_broadphase_t::NONE;
+      }
+      else if (std::strcmp (argv [i + 1], "grid") == 0)
+      {
+        config.tile_broadphase = tile_broadphase_t::GRID;
+      }
+      else if (std::strcmp (argv [i + 1], "sap") == 0)
+      {
+        config.tile_broadphase = tile_broadphase_t::SWEEP_AND_PRUNE;
+      }
+      else
+      {
+        std::printf ("unknown broadphase '%s'\n%s", argv [i + 1], HEADLESS_USAGE);
+        return 1;
+      }
+    }
+    else if (std::strcmp (argv [i], "--spawn") == 0)
+    {
+      if (std::strcmp (argv [i + 1], "uniform") == 0)
+      {
+        config.tile_spawn = tile_spawn_t::UNIFORM;
+      }
+      else if (std::strcmp (argv [i + 1], "clustered") == 0)
+      {
+        config.tile_spawn = tile_spawn_t::CLUSTERED;
+      }
+      else
+      {
+        std::printf ("unknown spawn pattern '%s'\n%s", argv [i + 1], HEADLESS_USAGE);
+        return 1;
+      }
+    }
+    else if (std::strcmp (argv [i], "--step-rate") == 0)
+    {
+      config.step_rate = std::atof (argv [i + 1]);
+    }
+    else if (std::strcmp (argv [i], "--pipeline") == 0)
+    {
+      if (std::strcmp (argv [i + 1], "on") == 0)
+      {
+        pipelined = true;
+      }
+      else if (std::strcmp (argv [i + 1], "off") == 0)
+      {
+        pipelined = false;
+      }
+      else
+      {
+        std::printf ("unknown pipeline mode '%s'\n%s", argv [i + 1], HEADLESS_USAGE);
+        return 1;
+      }
+    }
+    else if (std::strcmp (argv [i], "--seed") == 0)
+    {
+      config.seed = std::strtoull (argv [i + 1], nullptr, 10);
+    }
+    else if (std::strcmp (argv [i], "--stats-every") == 0)
+    {
+      stats_every = std::atoi (argv [i + 1]);
+    }
+    else if (std::strcmp (argv [i], "--record") == 0)
+    {
+      record_path = argv [i + 1];
+    }
+    else if (std::strcmp (argv [i], "--replay") == 0)
+    {
+      replay_path = argv [i + 1];
+    }
+    else if (std::strcmp (argv [i], "--fixed-elapsed") == 0)
+    {
+      fixed_elapsed_secs = std::atof (argv [i + 1]);
+    }
+    else if (std::strcmp (argv [i], "--checksum-every") == 0)
+    {
+      checksum_every = std::atoi (argv [i + 1]);
+    }
+    else if (std::strcmp (argv [i], "--trace") == 0)
+    {
+      trace_path = argv [i + 1];
+    }
+    else if (std::strcmp (argv [i], "--threads") == 0)
+    {
+      config.num_threads = (unsigned)std::strtoul (argv [i + 1], nullptr, 10);
+    }
+    else if (std::strcmp (argv [i], "--isa") == 0)
+    {
+      kernel_isa_t isa;
+      if (!parse_kernel_isa (argv [i + 1], isa))
+      {
+        std::printf ("unknown instruction set '%s'\n%s", argv [i + 1], HEADLESS_USAGE);
+        return 1;
+      }
+      if (!select_tile_kernels (isa))
+      {
+        std::printf ("this CPU doesn't support '%s'\n%s", argv [i + 1], HEADLESS_USAGE);
+        return 1;
+      }
+    }
+    else
+    {
+      std::printf ("unknown option '%s'\n%s", argv [i], HEADLESS_USAGE);
+      return 1;
+    }
+  }
+
+  // the replay's config and frames, run with this run's threads and kernels
+  replay_t replay = {};
+  if (replay_path != nullptr)
+  {
+    if (!load_replay (replay, replay_path))
+    {
+      std::printf ("couldn't read replay '%s'\n", replay_path);
+      return 1;
+    }
+    unsigned const num_threads = config.num_threads;
+    config = replay.config;
+    config.num_threads = num_threads;
+    frames = (int)replay.num_frames;
+  }
+
+  replay_recorder_t recorder = {};
+  if (record_path != nullptr && !initialise_replay_recorder (recorder, record_path, config))
+  {
+    std::printf ("couldn't write replay '%s'\n", record_path);
+    return 1;
+  }
+
+  // what frame { frame } is run with: from the replay if there is one, recorded if asked to
+  auto const get_frame = [&] (int frame)
+  {
+    replay_frame_t next = { elapsed_secs, 0 };
+    if (replay_path != nullptr)
+    {
+      next = replay.frames [frame];
+    }
+    if (fixed_elapsed_secs > 0.0)
+    {
+      next.elapsed = fixed_elapsed_secs;
+    }
+    record_replay_frame (recorder, next.elapsed, next.input);
+    return next;
+  };
+
+  PROFILE_THREAD_NAME ("main");
+
+  simulation_t simulation;
+  initialise_simulation (simulation, config);
+
+  frame_stats_t frame_stats;
+  initialise_frame_stats (frame_stats);
+  frame_clock_t frame_clock;
+
+  // every N frames, print the stats so far
+  auto const dump_stats = [&] (int frame)
+  {
+    if (stats_every > 0 && (frame + 1) % stats_every == 0)
+    {
+      std::printf ("frame %d\n", frame + 1);
+      print_frame_stats (stdout, frame_stats);
+    }
+  };
+
+  auto const start = std::chrono::steady_clock::now ();
+  initialise_frame_clock (frame_clock);
+  if (pipelined)
+  {
+    // same hand over as the graphical app, with nothing to draw:
+    // measures the sim thread, stepping and taking snapshots
+    frame_pipeline_t pipeline;
+    initialise_frame_pipeline (pipeline, simulation);
+    for (int frame = 0; frame < frames; ++frame)
+    {
+      frame_snapshot_t const& snapshot = begin_frame (pipeline);
+      record_frame_phase (frame_stats, FRAME_PHASE_ADVANCE, snapshot.advance_nanoseconds);
+      record_frame_phase (frame_stats, FRAME_PHASE_RENDER_PREP, snapshot.render_prep_nanoseconds);
+      replay_frame_t const next = get_frame (frame);
+      request_step (pipeline, next.elapsed, next.input);
+      end_frame (pipeline);
+
+      // how long the render thread waited for the sim thread, there is nothing else for it to do
+      record_frame_phase (frame_stats, FRAME_PHASE_FRAME, tick_frame_clock (frame_clock));
+      dump_stats (frame);
+    }
+    release_frame_pipeline (pipeline);
+  }
+  else
+  {
+    for (int frame = 0; frame < frames; ++frame)
+    {
+      replay_frame_t const next = get_frame (frame);
+      simulation.advance (next.elapsed, next.input);
+
+      record_frame_phase (frame_stats, FRAME_PHASE_FRAME, tick_frame_clock (frame_clock));
+      dump_stats (frame);
+
+      if (checksum_every > 0 && (frame + 1) % checksum_every == 0)
+      {
+        std::printf ("frame %d checksum %016llx\n", frame + 1, (unsigned long long)get_simulation_checksum (simulation));
+        initialise_frame_clock (frame_clock); // so the next frame's time doesn't include it
+      }
+    }
+  }
+  auto const end = std::chrono::steady_clock::now ();
+
+  double const total_secs = std::chrono::duration <double> (end - start).count ();
+  std::printf ("%u tiles, %d frames in %.5fs (%.5fms/frame), %s kernels, %u threads\n",
+    config.num_tiles, frames, total_secs, frames > 0 ? total_secs * 1000.0 / frames : 0.0, get_tile_kernels ().name,
+    simulation.jobs.num_threads);
+  std::printf ("frame arena peak %zu bytes\n", simulation.arena.peak);
+  std::printf ("checksum %016llx\n", (unsigned long long)get_simulation_checksum (simulation));
+  print_frame_stats (stdout, frame_stats);
+  release_frame_stats (frame_stats);
+
+  if (trace_path != nullptr)
+  {
+    print_profile_summary (stdout);
+    if (!write_profile_trace (trace_path))
+    {
+      std::printf ("couldn't write trace '%s'\n", trace_path);
+    }
+  }
+
+  release_simulation (simulation);
+  release_replay (replay);
+  if (record_path != nullptr && !release_replay_recorder (recorder))
+  {
+    std::printf ("couldn't write replay '%s'\n", record_path);
+    return 1;
+  }
+
+  return 0;
+}
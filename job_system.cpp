@@ -0,0 +1,225 @@
+#include "job_system.h"
+
+#include "profiler.h" // for PROFILE_ZONE, PROFILE_THREAD_NAME
+#include "utility.h"  // for wait_for_change
+
+
+// RUNS
+
+static std::uint64_t pack_run (unsigned next, unsigned end)
+{
+  return (std::uint64_t)next | ((std::uint64_t)end << 32);
+}
+
+static unsigned get_run_next (std::uint64_t run) { return (unsigned)run; }
+static unsigned get_run_end (std::uint64_t run)  { return (unsigned)(run >> 32); }
+
+
+/// <summary>
+/// take the chunk at the front of this thread's own run
+/// </summary>
+static bool take_chunk (job_run_t& run, unsigned& chunk)
+{
+  std::uint64_t chunks = run.chunks.load (std::memory_order_acquire);
+  while (get_run_next (chunks) < get_run_end (chunks))
+  {
+    if (run.chunks.compare_exchange_weak (chunks, pack_run (get_run_next (chunks) + 1u, get_run_end (chunks)),
+      std::memory_order_acq_rel, std::memory_order_acquire))
+    {
+      chunk = get_run_next (chunks);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/// <summary>
+/// take the back half of the longest run any other thread has left
+/// the first stolen chunk is returned, the rest become this thread's run
+/// </summary>
+/// <returns>false once every run is empty</returns>
+static bool steal_chunk (job_system_t& jobs, unsigned thief, unsigned& chunk)
+{
+  for (;;)
+  {
+    // Every run only ever shrinks until it is empty, and only the thread it belongs to refills it once it is,
+    // so a run that is seen with chunks left is never the same value as an earlier one (no ABA).
+    unsigned victim = thief;
+    std::uint64_t victim_chunks = 0;
+    unsigned most_left = 0;
+    for (unsigned t = 0; t < jobs.num_threads; t++)
+    {
+      std::uint64_t const chunks = jobs.runs [t].chunks.load (std::memory_order_acquire);
+      unsigned const left = get_run_end (chunks) - get_run_next (chunks);
+      if (t != thief && get_run_next (chunks) < get_run_end (chunks) && left > most_left)
+      {
+        victim = t;
+        victim_chunks = chunks;
+        most_left = left;
+      }
+    }
+
+    if (victim == thief)
+    {
+      return false;
+    }
+
+    unsigned const end = get_run_end (victim_chunks);
+    unsigned const stolen_begin = end - (most_left + 1u) / 2u;
+    if (jobs.runs [victim].chunks.compare_exchange_strong (victim_chunks, pack_run (get_run_next (victim_chunks), stolen_begin),
+      std::memory_order_acq_rel, std::memory_order_acquire))
+    {
+      chunk = stolen_begin;
+      if (stolen_begin + 1u < end)
+      {
+        jobs.runs [thief].chunks.store (pack_run (stolen_begin + 1u, end), std::memory_order_release);
+      }
+      return true;
+    }
+    // the victim or another thief got there first, look again
+  }
+}
+
+/// <summary>
+/// run chunks of the current loop on this thread until there are none left anywhere
+/// </summary>
+static void run_chunks (job_system_t& jobs, unsigned thread)
+{
+  PROFILE_ZONE ("chunks");
+
+  unsigned chunk;
+  while (take_chunk (jobs.runs [thread], chunk) || steal_chunk (jobs, thread, chunk))
+  {
+    unsigned const begin = chunk * jobs.grain;
+    unsigned const end = jobs.count - begin < jobs.grain ? jobs.count : begin + jobs.grain;
+    jobs.body (jobs.context, begin, end, chunk);
+  }
+}
+
+
+// WORKERS
+
+static void worker_main (job_system_t* jobs, unsigned thread)
+{
+  PROFILE_THREAD_NAME ("worker %u", thread);
+
+  unsigned seen = 0;
+  for (;;)
+  {
+    // wait for the next loop
+    seen = wait_for_change (jobs->generation, seen);
+
+    if (jobs->quit.load (std::memory_order_acquire))
+    {
+      return;
+    }
+
+    run_chunks (*jobs, thread);
+
+    // check in, the last worker out wakes the owner if it has gone to sleep
+    if (jobs->workers_busy.fetch_sub (1u, std::memory_order_acq_rel) == 1u)
+    {
+      jobs->workers_busy.notify_one ();
+    }
+  }
+}
+
+
+// GENERAL
+
+void run_parallel_for (job_system_t& jobs, unsigned count, unsigned grain,
+  void (*body) (void* context, unsigned begin, unsigned end, unsigned chunk), void* context)
+{
+  unsigned const num_chunks = get_num_chunks (count, grain);
+
+  // not worth waking anyone
+  if (jobs.workers.empty () || num_chunks <= 1u)
+  {
+    for (unsigned chunk = 0; chunk < num_chunks; chunk++)
+    {
+      unsigned const begin = chunk * grain;
+      body (context, begin, count - begin < grain ? count : begin + grain, chunk);
+    }
+    return;
+  }
+
+  jobs.body = body;
+  jobs.context = context;
+  jobs.count = count;
+  jobs.grain = grain;
+
+  // deal each thread an equal run of consecutive chunks
+  for (unsigned t = 0; t < jobs.num_threads; t++)
+  {
+    unsigned const next = (unsigned)((std::uint64_t)num_chunks * t / jobs.num_threads);
+    unsigned const end = (unsigned)((std::uint64_t)num_chunks * (t + 1u) / jobs.num_threads);
+    jobs.runs [t].chunks.store (pack_run (next, end), std::memory_order_relaxed);
+  }
+  jobs.workers_busy.store ((unsigned)jobs.workers.size (), std::memory_order_relaxed);
+
+  // go
+  jobs.generation.fetch_add (1u, std::memory_order_release);
+  jobs.generation.notify_all ();
+
+  run_chunks (jobs, 0);
+
+  // wait for every worker to check in, so nothing is still touching this loop's data, or its runs
+  unsigned busy = jobs.workers_busy.load (std::memory_order_acquire);
+  while (busy != 0u)
+  {
+    busy = wait_for_change (jobs.workers_busy, busy);
+  }
+}
+
+
+void initialise_job_system (job_system_t& jobs, unsigned num_threads)
+{
+  if (num_threads == 0u)
+  {
+    num_threads = std::thread::hardware_concurrency ();
+  }
+  if (num_threads == 0u)
+  {
+    num_threads = 1u; // hardware_concurrency couldn't tell
+  }
+
+  jobs.num_threads = num_threads;
+  jobs.runs = new job_run_t [num_threads];
+  for (unsigned t = 0; t < num_threads; t++)
+  {
+    jobs.runs [t].chunks.store (0, std::memory_order_relaxed);
+  }
+
+  jobs.body = nullptr;
+  jobs.context = nullptr;
+  jobs.count = 0;
+  jobs.grain = 1;
+  jobs.generation.store (0, std::memory_order_relaxed);
+  jobs.workers_busy.store (0, std::memory_order_relaxed);
+  jobs.quit.store (false, std::memory_order_relaxed);
+
+  jobs.workers.reserve (num_threads - 1u);
+  for (unsigned t = 1; t < num_threads; t++)
+  {
+    jobs.workers.emplace_back (worker_main, &jobs, t);
+  }
+}
+
+void release_job_system (job_system_t& jobs)
+{
+  jobs.quit.store (true, std::memory_order_release);
+  jobs.generation.fetch_add (1u, std::memory_order_release);
+  jobs.generation.notify_all ();
+
+  for (std::thread& worker : jobs.workers)
+  {
+    worker.join ();
+  }
+  jobs.workers.clear ();
+
+  delete [] jobs.runs;
+  jobs.runs = nullptr;
+  jobs.num_threads = 0;
+  jobs.chunk_counts.clear ();
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <atomic>  // for std::atomic
+#include <cstdint> // for std::uint64_t
+#include <thread>  // for std::thread
+#include <vector>  // for std::vector
+
+
+// JOB SYSTEM
+//
+// A fixed pool of worker threads that split loops over index ranges (e.g. the tiles_t arrays) between them.
+// parallel_for cuts [0, count) into chunks of { grain } indices and deals each thread, the calling thread included,
+// an equal run of consecutive chunks. Each thread takes chunks off the front of its own run,
+// and once that is empty it steals the back half of the biggest run another thread still has left.
+// Uneven chunks (e.g. a crowded part of the screen) are soaked up by whoever finishes first,
+// while each thread mostly walks its own memory in order.
+//
+// parallel_for returns once every chunk has run and every worker has checked back in,
+// i.e. it is a barrier: everything written inside it can be read by the caller straight afterwards.
+// Between loops the workers spin for a short while before going to sleep,
+// so the stages of one frame hand over to each other without waking threads through the OS.
+//
+// Loops are not nested, only the thread that owns the job system calls parallel_for.
+// Loops small enough to fit in one chunk, and job systems with no workers, run on the calling thread.
+
+
+/// <summary>
+/// one thread's run of chunks, [next, end) packed into 64 bits so it can be taken from and stolen with one CAS
+/// on its own cache line, so threads taking chunks don't invalidate each other's
+/// </summary>
+struct alignas (64) job_run_t
+{
+  std::atomic <std::uint64_t> chunks;
+};
+
+
+struct job_system_t
+{
+  unsigned num_threads; // worker threads + the thread that owns the job system
+  std::vector <std::thread> workers;
+  job_run_t* runs;      // { num_threads } entries, index 0 is the owning thread
+
+  // the loop currently running
+  void (*body) (void* context, unsigned begin, unsigned end, unsigned chunk);
+  void* context;
+  unsigned count;
+  unsigned grain;
+
+  // bumped once per loop, workers wait for it to change
+  std::atomic <unsigned> generation;
+  // workers still inside the current loop, the owning thread waits for it to reach 0
+  std::atomic <unsigned> workers_busy;
+  std::atomic <bool> quit;
+
+  // per chunk results for parallel_gather, grown as needed
+  std::vector <unsigned> chunk_counts;
+};
+
+
+/// <summary>
+/// start { num_threads } - 1 workers, the calling thread is the last one
+/// 0 means one thread per hardware thread
+/// </summary>
+void initialise_job_system (job_system_t& jobs, unsigned num_threads);
+
+/// <summary>
+/// stop and join every worker
+/// </summary>
+void release_job_system (job_system_t& jobs);
+
+
+/// <summary>
+/// number of chunks parallel_for splits { count } indices into
+/// </summary>
+inline unsigned get_num_chunks (unsigned count, unsigned grain)
+{
+  return (count + grain - 1u) / grain;
+}
+
+/// <summary>
+/// call body (context, begin, end, chunk) for every chunk of [0, count), spread over every thread
+/// prefer the parallel_for template below
+/// </summary>
+void run_parallel_for (job_system_t& jobs, unsigned count, unsigned grain,
+  void (*body) (void* context, unsigned begin, unsigned end, unsigned chunk), void* context);
+
+
+/// <summary>
+/// call body (begin, end) for every chunk of [0, count), spread over every thread
+/// chunks start on multiples of { grain } and are { grain } long, except the last one
+/// body must only write data belonging to its own chunk
+/// </summary>
+template <typename body_t>
+void parallel_for (job_system_t& jobs, unsigned count, unsigned grain, body_t const& body)
+{
+  run_parallel_for (jobs, count, grain,
+    [] (void* context, unsigned begin, unsigned end, unsigned)
+    {
+      (*(body_t const*)context) (begin, end);
+    },
+    (void*)&body);
+}
+
+/// <summary>
+/// parallel_for where each chunk writes a list of results to out [begin] onwards, at most one per index in the chunk
+/// body (begin, end, out + begin) returns how many it wrote
+/// the lists are then packed down to the front of { out } in chunk order,
+/// so the result is the same as one thread running the whole loop, however many threads there are
+/// </summary>
+/// <returns>the total number of results</returns>
+template <typename result_t, typename body_t>
+unsigned parallel_gather (job_system_t& jobs, unsigned count, unsigned grain, result_t* out, body_t const& body)
+{
+  unsigned const num_chunks = get_num_chunks (count, grain);
+  if (jobs.chunk_counts.size () < num_chunks)
+  {
+    jobs.chunk_counts.resize (num_chunks);
+  }
+
+  struct gather_t
+  {
+    body_t const* body;
+    result_t* out;
+    unsigned* chunk_counts;
+  };
+  gather_t gather = { &body, out, jobs.chunk_counts.data () };
+
+  run_parallel_for (jobs, count, grain,
+    [] (void* context, unsigned begin, unsigned end, unsigned chunk)
+    {
+      gather_t const& gather = *(gather_t const*)context;
+      gather.chunk_counts [chunk] = (*gather.body) (begin, end, gather.out + begin);
+    },
+    &gather);
+
+  // each chunk's results start at or after where they are going, so they can be moved down in order
+  unsigned total = 0;
+  for (unsigned chunk = 0; chunk < num_chunks; chunk++)
+  {
+    result_t const* chunk_out = out + chunk * grain;
+    unsigned const chunk_count = jobs.chunk_counts [chunk];
+    if (chunk_out != out + total)
+    {
+      for (unsigned i = 0; i < chunk_count; i++)
+      {
+        out [total + i] = chunk_out [i];
+      }
+    }
+    total += chunk_count;
+  }
+
+  return total;
+}
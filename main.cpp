@@ -96,18 +96,45 @@
 // Original Author: A.Hamilton - 2022
 
 
-#include "magpie.h"    // for magpie window/rendering components
+#include "magpie.h"         // for magpie window/rendering components
 
-#include "collision.h" // for resolve_collisions
-#include "player.h"    // for player_t
-#include "tiles.h"     // for tiles_t
-#include "walls.h"     // for walls_t
+#include "frame_pipeline.h" // for frame_pipeline_t, frame_snapshot_t
+#include "frame_stats.h"    // for frame_clock_t, frame_stats_t
+#include "profiler.h"       // for PROFILE_ZONE, PROFILE_THREAD_NAME, write_profile_trace
+#include "replay.h"         // for replay_recorder_t
+#include "render.h"         // for render_resources_t, render_player, render_tiles, render_walls
+#include "simulation.h"     // for simulation_t
 
-#include <cstdlib>     // for srand
-#include "timer.h"
+#include <cstdio>           // for std::fopen
+#include <cstdlib>          // for srand, std::getenv
 
 
+/// <summary>
+/// turn the state of the keyboard/controller into the simulation's input bitmask
+/// </summary>
+static player_input_t poll_player_input (magpie::input& controller)
+{
+  player_input_t input = 0;
+
+  if (controller.is_key_down (magpie::keyboard_key::LEFT) || controller.is_down (magpie::controller_key::LEFT))
+  {
+    input |= PLAYER_INPUT_LEFT;
+  }
+  if (controller.is_key_down (magpie::keyboard_key::RIGHT) || controller.is_down (magpie::controller_key::RIGHT))
+  {
+    input |= PLAYER_INPUT_RIGHT;
+  }
+  if (controller.is_key_down (magpie::keyboard_key::UP) || controller.is_down (magpie::controller_key::UP))
+  {
+    input |= PLAYER_INPUT_UP;
+  }
+  if (controller.is_key_down (magpie::keyboard_key::DOWN) || controller.is_down (magpie::controller_key::DOWN))
+  {
+    input |= PLAYER_INPUT_DOWN;
+  }
 
+  return input;
+}
 
 
 ENTRY_POINT
@@ -141,92 +168,82 @@ ENTRY_POINT
 
   // SETUP
 
-  player_t* player;
-  initialise_player (player);
+  magpie::input controller;
+  controller.initialise (0);
+
+  simulation_config_t config = get_default_simulation_config ();
+  config.screen_dim = { (double)renderer.get_screen_dimensions ().x, (double)renderer.get_screen_dimensions ().y, 0.0, 0.0 };
+
+  render_resources_t render_resources;
+  if (!initialise_render_resources (render_resources, renderer, config.num_tiles))
+  {
+    MAGPIE_DASSERT (false);
+  }
+  // the simulation reads object sizes, not the spritesheet itself
+  config.sprites = render_resources.sprites;
+
+  simulation_t simulation;
+  initialise_simulation (simulation, config);
 
-  tiles_t tiles;
-  initialise_tiles (tiles);
+  // from here the simulation steps on its own thread, see frame_pipeline.h
+  frame_pipeline_t pipeline;
+  initialise_frame_pipeline (pipeline, simulation);
 
-  vector4 screen_dim = { (double)renderer.get_screen_dimensions().x, (double)renderer.get_screen_dimensions().y, 0.0, 0.0 };
-  walls_t walls = initialise_walls(screen_dim);
+  // frame timer, and how long frames are taking, written out at exit rather than printed every frame
+  frame_stats_t frame_stats;
+  initialise_frame_stats (frame_stats);
 
-  // frame timer
-  LARGE_INTEGER clock_freq;
-  QueryPerformanceFrequency (&clock_freq); // ask Windows for the CPU timer frequency
-  double const timer_multiplier_secs = (double)clock_freq.QuadPart;
+  // every frame's time and input, so the session can be run again headless (headless --replay PATH)
+  // only if asked for, by setting SHOT1_RECORD to the file to write, e.g. SHOT1_RECORD=replay.bin
+  replay_recorder_t recorder = {};
+  if (char const* const record_path = std::getenv ("SHOT1_RECORD"))
+  {
+    initialise_replay_recorder (recorder, record_path, config);
+  }
 
-  LARGE_INTEGER qpc_start, qpc_end;
-  QueryPerformanceCounter (&qpc_start); // start frame timer
+  frame_clock_t frame_clock;
+  initialise_frame_clock (frame_clock);
   // have really small first frame elapsed seconds, rather than an unknown time
 
 
   // GAME LOOP
 
+  PROFILE_THREAD_NAME ("main");
   while (renderer.process_os_messages ())
   {
-    QueryPerformanceCounter (&qpc_end); // end frame timer
-    double const elapsed_secs = (double)(qpc_end.QuadPart - qpc_start.QuadPart) / timer_multiplier_secs;
+    PROFILE_ZONE ("frame");
 
-    magpie::printf ("elapsed = %.5fs\n", elapsed_secs);
+    std::uint64_t const elapsed_nanoseconds = tick_frame_clock (frame_clock);
+    double const elapsed_secs = elapsed_nanoseconds / 1e9;
+    record_frame_phase (frame_stats, FRAME_PHASE_FRAME, elapsed_nanoseconds);
 
-    QueryPerformanceCounter (&qpc_start); // start frame timer
 
+    // the last frame the sim thread finished
+    frame_snapshot_t const& frame = begin_frame (pipeline);
+    record_frame_phase (frame_stats, FRAME_PHASE_ADVANCE, frame.advance_nanoseconds);
+    record_frame_phase (frame_stats, FRAME_PHASE_RENDER_PREP, frame.render_prep_nanoseconds);
 
-    magpie::spritesheet spritesheet;
-    if (!spritesheet.initialise (renderer, "data/textures/SHOT1/sprites.xml"))
-    {
-      MAGPIE_DASSERT (false);
-    }
-    magpie::_2d::sprite_batch sprite_batch;
-    // We need enough capacity for this sprite batch to render 1 player sprite, 4 wall sprites and { NUM_TILES } tile sprites
-    // Each sprite requires memory for 4 vertices in RAM.
-    if (!sprite_batch.initialise (renderer,
-      spritesheet.get_texture (),
-      NUM_TILES * 10u))
+    if (!update_render_resources (render_resources, renderer, frame.num_tiles))
     {
       MAGPIE_DASSERT (false);
     }
+    magpie::_2d::sprite_batch& sprite_batch = render_resources.sprite_batch;
 
 
     // UPDATE
+    // runs on the sim thread while { frame } is drawn below
     {
-      // PLAYER
-      {
-        player->update (elapsed_secs, renderer, spritesheet);
-      }
-
-      // TILES
-      //{
-      //  for (auto it = tiles.data.begin (); it != tiles.data.end (); it++)
-      //  {
-      //    if ((*it).second != nullptr)
-      //    {
-      //      (*it).second->update (elapsed_secs, spritesheet);
-      //    }
-      //  }
-      //}
-      {
-          tiles.update(elapsed_secs, spritesheet);
-      }
-
-      // COLLISIONS
-      timer MyTimer;
-      {
-        vector4 screen_dim = { (double)renderer.get_screen_dimensions ().x, (double)renderer.get_screen_dimensions ().y, 0.0, 0.0 };
-        walls_t walls = initialise_walls (screen_dim);
-        resolve_collisions (spritesheet, renderer,
-          *player, tiles, walls);
-        release_walls (walls);
-      }
-
-      check_player_needs_replacing (player);
-
-      replace_expired_tiles (tiles);
+      player_input_t const input = poll_player_input (controller);
+      record_replay_frame (recorder, elapsed_secs, input);
+      request_step (pipeline, elapsed_secs, input);
     }
 
 
     // RENDER
     {
+      PROFILE_ZONE ("submit");
+      std::uint64_t const submit_start = get_clock_nanoseconds ();
+
       ////////////////////////////////////////////////
       //// DO NOT EDIT/DELETE/MOVE CODE BELOW >>> ////
       ////////////////////////////////////////////////
@@ -250,32 +267,17 @@ ENTRY_POINT
 
       // PLAYER
       {
-        player->render (renderer, sprite_batch, spritesheet);
+        render_player (renderer, sprite_batch, render_resources.sprite_rects, frame);
       }
 
       // TILES
-      //{
-      //  for (auto it = tiles.data.begin (); it != tiles.data.end (); it++)
-      //  {
-      //    if ((*it).second != nullptr)
-      //    {
-      //      (*it).second->render (renderer, sprite_batch, spritesheet);
-      //    }
-      //  }
-      //}
       {
-          tiles.render(renderer, sprite_batch, spritesheet);
+        render_tiles (renderer, sprite_batch, render_resources.sprite_rects, frame);
       }
 
       // WALLS
       {
-        vector4 screen_dim = { (double)renderer.get_screen_dimensions ().x, (double)renderer.get_screen_dimensions ().y, 0.0, 0.0 };
-        walls_t walls = initialise_walls (screen_dim);
-        for (auto it = walls.data.begin (); it != walls.data.end (); it++)
-        {
-          it->render (renderer, sprite_batch, spritesheet);
-        }
-        release_walls (walls);// Sleep (10);
+        render_walls (renderer, sprite_batch, render_resources.sprite_rects, simulation.walls);
       }
 
 
@@ -297,20 +299,31 @@ ENTRY_POINT
       ////////////////////////////////////////////////
       //// <<< DO NOT EDIT/DELETE/MOVE CODE ABOVE ////
       ////////////////////////////////////////////////
-    }
 
+      record_frame_phase (frame_stats, FRAME_PHASE_SUBMIT, get_clock_nanoseconds () - submit_start);
+    }
 
-    sprite_batch.release (renderer);
-    spritesheet.release (renderer);
+    end_frame (pipeline);
   } // GAME LOOP: END
 
 
   // RELEASE RESOURCES
 
   {
-    release_tiles (tiles);
-    release_player (player);
-    release_walls(walls);
+    release_frame_pipeline (pipeline);
+#if defined (SHOT1_PROFILE)
+    // every thread that recorded zones has stopped by now
+    write_profile_trace ("profile_trace.json");
+#endif
+    if (std::FILE* const stats_file = std::fopen ("frame_stats.txt", "w"))
+    {
+      print_frame_stats (stats_file, frame_stats);
+      std::fclose (stats_file);
+    }
+    release_frame_stats (frame_stats);
+    release_replay_recorder (recorder);
+    release_simulation (simulation);
+    release_render_resources (render_resources, renderer);
     renderer.release ();
   }
 
@@ -1,116 +1,111 @@
 #pragma once
 
-#include "magpie.h"    // for magpie::renderer, magpie::_2d::sprite_batch, magpie::spritesheet, magpie::input
-
 #include "constants.h" // for object_type_t, object_id_t...
+#include "soa_pool.h"  // for soa_pool_t, real_t
 #include "utility.h"   // for vector4
 
+#include <cstdint>     // for std::uint8_t
 
-// PLAYER
-
-class player_t
-{
-public:
-  player_t () = delete;
-  player_t (double position_x, double position_y);
-
-  virtual void update (double elapsed, magpie::renderer const& renderer, magpie::spritesheet spritesheet) = 0;
-  virtual void render (magpie::renderer& renderer,
-    magpie::_2d::sprite_batch& sprite_batch,
-    magpie::spritesheet spritesheet) = 0;
-
-  /// <summary>
-  /// the player has collided with something
-  /// check what type of object it is and resolve the collision appropriately
-  /// </summary>
-  /// <param name="other_type">the identifier of the other object</param>
-  /// <param name="other_data">pointer to some data, could be a tile or wall, or anything!</param>
-  /// <param name="spritesheet">spritesheet data, required to get size of other object</param>
-  virtual void on_collision (object_type_t other_type, void* other_data, magpie::spritesheet spritesheet) = 0;
-  virtual object_id_t get_id () const = 0;
-
-
-public:
-  vector4 position;
-  object_id_t new_player_id;
-};
 
+// PLAYER INPUT
 
-// PLAYER NORMAL
+/// <summary>
+/// bitmask of the directions the user is holding this frame
+/// filled in by whoever owns the input device (the front end, or a headless driver)
+/// </summary>
+using player_input_t = std::uint8_t;
+player_input_t const PLAYER_INPUT_LEFT  = 1u << 0;
+player_input_t const PLAYER_INPUT_RIGHT = 1u << 1;
+player_input_t const PLAYER_INPUT_UP    = 1u << 2;
+player_input_t const PLAYER_INPUT_DOWN  = 1u << 3;
+
+
+// PLAYER FIELDS
+//
+// One column of players_t each, see soa_pool.h.
+// A player is plain data with a state tag, PLAYER_ID_NORMAL or PLAYER_ID_WIDE.
+// The 2 states only differ in their numbers, a wide player moves slower and reverts to normal after { PLAYER_WIDE_LIFETIME } seconds,
+// so both are updated by the same code, and changing state just overwrites them in place (see set_player_state).
+
+// the player has always moved in doubles, and there is only the one
+precision_t const PLAYER_PRECISION = precision_t::DOUBLE;
+using player_real_t = real_t <PLAYER_PRECISION>;
+
+// HOT: read and written by every step
+struct player_position_x_t { using value_t = player_real_t; };
+struct player_position_y_t { using value_t = player_real_t; };
+struct player_state_t { using value_t = object_id_t; };
+struct player_speed_multiplier_t { using value_t = player_real_t; }; // of { PLAYER_SPEED }
+// seconds left before a wide player reverts to normal, counted down by update_players
+// a normal player's is infinite, so the countdown needs no check of the player's state
+struct player_lifetime_t { using value_t = player_real_t; };
+// the state the player changes to at the end of the step, OBJECT_ID_NONE to stay as it is
+// set by whatever decides the player should change, e.g. eating a wide tile (see collision_handler_t)
+struct player_new_state_t { using value_t = object_id_t; };
+
+// COLD: only written once a step, for the front end
+// where each player was before the last step, saved by update_players
+struct player_prev_position_x_t { using value_t = player_real_t; };
+struct player_prev_position_y_t { using value_t = player_real_t; };
+
+using player_pool_t = soa_pool_t <
+  player_position_x_t, player_position_y_t, player_state_t, player_speed_multiplier_t, player_lifetime_t, player_new_state_t,
+  player_prev_position_x_t, player_prev_position_y_t>;
+
+
+// PLAYERS
 
 /// <summary>
-/// standard user controlled player
+/// every player in the game, { count } of them, in the columns of a player_pool_t
 /// </summary>
-class player_normal_t : public player_t
+struct players_t : player_pool_t
 {
-public:
-  player_normal_t () = delete;
-  player_normal_t (double position_x, double position_y);
-
-  void update (double elapsed, magpie::renderer const& renderer, magpie::spritesheet spritesheet) override;
-  void render (magpie::renderer& renderer,
-    magpie::_2d::sprite_batch& sprite_batch,
-    magpie::spritesheet spritesheet) override;
-
-  void on_collision (object_type_t other_type, void* other_data, magpie::spritesheet spritesheet) override;
-  object_id_t get_id () const override;
-
-
-private:
-  magpie::input controller;
 };
 
 
-// PLAYER WIDE
-
 /// <summary>
-/// has a greater area for consuming tiles than player_normal
-/// reverts back to player_normal after { PLAYER_WIDE_LIFETIME } seconds
-/// slower movement speed than player_normal
+/// the user controlled player, the only one the game has
 /// </summary>
-class player_wide_t : public player_t
-{
-public:
-  player_wide_t () = delete;
-  player_wide_t (double position_x, double position_y);
+unsigned const USER_PLAYER = 0u;
 
-  void update (double elapsed, magpie::renderer const& renderer, magpie::spritesheet spritesheet) override;
-  void render (magpie::renderer& renderer,
-    magpie::_2d::sprite_batch& sprite_batch,
-    magpie::spritesheet spritesheet) override;
+/// <summary>
+/// where player { index } is now
+/// </summary>
+vector4 get_player_position (players_t const& players, unsigned index);
 
-  void on_collision (object_type_t other_type, void* other_data, magpie::spritesheet spritesheet) override;
-  object_id_t get_id () const override;
+/// <summary>
+/// where player { index } was before the last step
+/// </summary>
+vector4 get_player_prev_position (players_t const& players, unsigned index);
 
+/// <summary>
+/// put player { index } in { state }, PLAYER_ID_NORMAL or PLAYER_ID_WIDE, and give it that state's speed and lifetime
+/// the player stays where it is, nothing is allocated
+/// </summary>
+void set_player_state (players_t& players, unsigned index, object_id_t state);
 
-private:
-  magpie::input controller;
-  double lifetime;
-};
+/// <summary>
+/// move every player by the directions in { input }, at its own speed, and count down its lifetime
+/// a wide player whose lifetime runs out asks to change back to normal
+/// </summary>
+/// <param name="elapsed">step time, in seconds</param>
+void update_players (players_t& players, double elapsed, player_input_t input);
 
 
 // GENERAL
 
 /// <summary>
-/// pre game loop player set up code
-/// </summary>
-void initialise_player (player_t*& player);
-
-/// <summary>
-/// check if player needs replacing
+/// pre game loop players set up code
+/// one normal player, in the middle of the screen
 /// </summary>
-/// <param name="player">reference to a pointer - player to check for replacement</param>
-void check_player_needs_replacing (player_t*& player);
+void initialise_players (players_t& players);
 
 /// <summary>
-/// post game loop player tear down code
+/// end of the step, change each player that asked to into its new state
 /// </summary>
-void release_player (player_t*& player);
-
+void check_player_needs_replacing (players_t& players);
 
 /// <summary>
-/// search the spritesheet for the sub-sprite associated with a particular type of plater
-/// NOTE: this app uses the size of the sub-sprite as the size of the object in the game world.
+/// post game loop players tear down code
 /// </summary>
-/// <returns>a pointer to the texture_rect of the object's sub-sprite on the spritesheet</returns>
-texture_rect const* get_player_texture_rect (magpie::spritesheet const& spritesheet, object_id_t id);
+void release_players (players_t& players);
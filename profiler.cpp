@@ -0,0 +1,295 @@
+#include "profiler.h"
+
+#if defined (SHOT1_PROFILE)
+
+#include <algorithm> // for std::sort, std::min
+#include <atomic>    // for std::atomic
+#include <chrono>    // for std::chrono::steady_clock
+#include <cstdarg>   // for va_list
+#include <cstring>   // for std::strcmp
+#include <vector>    // for std::vector
+
+
+// RINGS
+
+/// <summary>
+/// one thread's zones
+/// only that thread writes to it, and it is never freed, so the trace can be read after the thread has gone
+/// </summary>
+struct profile_thread_t
+{
+  // zones ever recorded, the ring holds the last { PROFILE_EVENTS_PER_THREAD } of them
+  // stored with release once a zone is written, so a reader that loads it with acquire sees every zone before it
+  std::atomic <std::uint32_t> written;
+  profile_event_t* events;
+
+  char name [32];
+  unsigned index;
+
+  // zones open on this thread, innermost last
+  char const* open [PROFILE_MAX_DEPTH];
+  std::uint32_t depth;
+};
+
+
+static std::chrono::steady_clock::time_point const PROFILE_EPOCH = std::chrono::steady_clock::now ();
+
+static std::atomic <profile_thread_t*> profile_threads [PROFILE_MAX_THREADS];
+static std::atomic <unsigned> num_profile_threads { 0u };
+
+static thread_local profile_thread_t* current_profile_thread = nullptr;
+static thread_local bool is_profile_thread_dropped = false;
+
+
+static std::uint64_t get_profile_time ()
+{
+  return (std::uint64_t)std::chrono::duration_cast <std::chrono::nanoseconds> (std::chrono::steady_clock::now () - PROFILE_EPOCH).count ();
+}
+
+/// <summary>
+/// the calling thread's ring, made the first time it records a zone
+/// </summary>
+/// <returns>nullptr if there are already { PROFILE_MAX_THREADS } rings</returns>
+static profile_thread_t* get_profile_thread ()
+{
+  if (current_profile_thread == nullptr && !is_profile_thread_dropped)
+  {
+    unsigned const index = num_profile_threads.fetch_add (1u, std::memory_order_relaxed);
+    if (index >= PROFILE_MAX_THREADS)
+    {
+      is_profile_thread_dropped = true;
+      return nullptr;
+    }
+
+    profile_thread_t* const thread = new profile_thread_t;
+    thread->written.store (0u, std::memory_order_relaxed);
+    thread->events = new profile_event_t [PROFILE_EVENTS_PER_THREAD];
+    std::snprintf (thread->name, sizeof (thread->name), "thread %u", index);
+    thread->index = index;
+    thread->depth = 0;
+
+    profile_threads [index].store (thread, std::memory_order_release);
+    current_profile_thread = thread;
+  }
+
+  return current_profile_thread;
+}
+
+
+// ZONES
+
+profile_zone_t::profile_zone_t (char const* name)
+{
+  profile_thread_t* const thread = get_profile_thread ();
+  recorded = thread != nullptr;
+  if (recorded)
+  {
+    if (thread->depth < PROFILE_MAX_DEPTH)
+    {
+      thread->open [thread->depth] = name;
+    }
+    thread->depth++;
+  }
+
+  // last, so setting up isn't timed
+  begin = get_profile_time ();
+}
+
+profile_zone_t::~profile_zone_t ()
+{
+  std::uint64_t const end = get_profile_time ();
+  if (!recorded)
+  {
+    return;
+  }
+
+  profile_thread_t* const thread = current_profile_thread;
+  std::uint32_t const depth = --thread->depth;
+  if (depth >= PROFILE_MAX_DEPTH)
+  {
+    return;
+  }
+
+  std::uint32_t const written = thread->written.load (std::memory_order_relaxed);
+  profile_event_t& event = thread->events [written % PROFILE_EVENTS_PER_THREAD];
+  event.name = thread->open [depth];
+  event.parent = depth > 0u ? thread->open [depth - 1u] : nullptr;
+  event.begin = begin;
+  event.end = end;
+  event.depth = depth;
+  thread->written.store (written + 1u, std::memory_order_release);
+}
+
+void set_profile_thread_name (char const* format, ...)
+{
+  profile_thread_t* const thread = get_profile_thread ();
+  if (thread == nullptr)
+  {
+    return;
+  }
+
+  va_list args;
+  va_start (args, format);
+  std::vsnprintf (thread->name, sizeof (thread->name), format, args);
+  va_end (args);
+}
+
+
+// OUTPUT
+
+/// <summary>
+/// call visit (thread, event) for every zone still in every ring, oldest first within each thread
+/// </summary>
+template <typename visit_t>
+static void for_each_profile_event (visit_t const& visit)
+{
+  unsigned const num_threads = std::min (num_profile_threads.load (std::memory_order_relaxed), PROFILE_MAX_THREADS);
+  for (unsigned t = 0; t < num_threads; t++)
+  {
+    // counted before its ring was stored, may not be there yet
+    profile_thread_t const* const thread = profile_threads [t].load (std::memory_order_acquire);
+    if (thread == nullptr)
+    {
+      continue;
+    }
+
+    std::uint32_t const written = thread->written.load (std::memory_order_acquire);
+    std::uint32_t const first = written > PROFILE_EVENTS_PER_THREAD ? written - PROFILE_EVENTS_PER_THREAD : 0u;
+    for (std::uint32_t e = first; e != written; e++)
+    {
+      visit (*thread, thread->events [e % PROFILE_EVENTS_PER_THREAD]);
+    }
+  }
+}
+
+/// <summary>
+/// { text } as a JSON string's contents, zone names are plain literals but may still hold a quote
+/// </summary>
+static void write_json_text (std::FILE* file, char const* text)
+{
+  for (char const* c = text; *c != '\0'; c++)
+  {
+    if (*c == '"' || *c == '\\')
+    {
+      std::fputc ('\\', file);
+    }
+    std::fputc (*c, file);
+  }
+}
+
+bool write_profile_trace (char const* path)
+{
+  std::FILE* const file = std::fopen (path, "w");
+  if (file == nullptr)
+  {
+    return false;
+  }
+
+  // Chrome trace event format: complete ("X") events with a start and duration in microseconds,
+  // the viewer nests zones on the same thread by time, and metadata ("M") events name the threads
+  std::fprintf (file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  bool first = true;
+
+  unsigned const num_threads = std::min (num_profile_threads.load (std::memory_order_relaxed), PROFILE_MAX_THREADS);
+  for (unsigned t = 0; t < num_threads; t++)
+  {
+    profile_thread_t const* const thread = profile_threads [t].load (std::memory_order_acquire);
+    if (thread == nullptr)
+    {
+      continue;
+    }
+
+    std::fprintf (file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"", first ? "" : ",\n", thread->index);
+    write_json_text (file, thread->name);
+    std::fprintf (file, "\"}}");
+    first = false;
+  }
+
+  for_each_profile_event ([&] (profile_thread_t const& thread, profile_event_t const& event)
+  {
+    std::fprintf (file, "%s{\"name\":\"", first ? "" : ",\n");
+    write_json_text (file, event.name);
+    std::fprintf (file, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+      thread.index, (double)event.begin / 1000.0, (double)(event.end - event.begin) / 1000.0);
+    first = false;
+  });
+
+  std::fprintf (file, "\n]}\n");
+  return std::fclose (file) == 0;
+}
+
+
+/// <summary>
+/// every zone with the same name, run inside zones with the same name, summed
+/// </summary>
+struct profile_total_t
+{
+  char const* name;
+  char const* parent;
+  std::uint32_t depth;
+  std::uint64_t first_begin; // to print phases in the order they first ran
+  std::uint64_t nanoseconds;
+  std::uint64_t count;
+};
+
+static bool is_same_name (char const* lhs, char const* rhs)
+{
+  // the same literal in 2 files may or may not be merged into one
+  return lhs == rhs || (lhs != nullptr && rhs != nullptr && std::strcmp (lhs, rhs) == 0);
+}
+
+static void print_profile_totals (std::FILE* file, std::vector <profile_total_t> const& totals,
+  char const* parent, std::uint32_t depth)
+{
+  for (profile_total_t const& total : totals)
+  {
+    if (total.depth == depth && is_same_name (total.parent, parent))
+    {
+      double const milliseconds = (double)total.nanoseconds / 1e6;
+      std::fprintf (file, "%*s%-*s %10.3fms %8llu calls %9.4fms/call\n",
+        (int)depth * 2, "", 32 - (int)depth * 2, total.name,
+        milliseconds, (unsigned long long)total.count, milliseconds / (double)total.count);
+      print_profile_totals (file, totals, total.name, depth + 1u);
+    }
+  }
+}
+
+void print_profile_summary (std::FILE* file)
+{
+  std::vector <profile_total_t> totals;
+  for_each_profile_event ([&] (profile_thread_t const&, profile_event_t const& event)
+  {
+    for (profile_total_t& total : totals)
+    {
+      if (total.depth == event.depth && is_same_name (total.name, event.name) && is_same_name (total.parent, event.parent))
+      {
+        total.first_begin = std::min (total.first_begin, event.begin);
+        total.nanoseconds += event.end - event.begin;
+        total.count++;
+        return;
+      }
+    }
+    totals.push_back ({ event.name, event.parent, event.depth, event.begin, event.end - event.begin, 1u });
+  });
+
+  std::sort (totals.begin (), totals.end (), [] (profile_total_t const& lhs, profile_total_t const& rhs)
+  {
+    return lhs.first_begin < rhs.first_begin;
+  });
+
+  print_profile_totals (file, totals, nullptr, 0u);
+}
+
+#else
+
+bool write_profile_trace (char const*)
+{
+  return false;
+}
+
+void print_profile_summary (std::FILE* file)
+{
+  std::fprintf (file, "no profile, built without SHOT1_PROFILE\n");
+}
+
+#endif
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint> // for std::uint32_t, std::uint64_t
+#include <cstdio>  // for std::FILE
+
+
+// PROFILER
+//
+// Scoped zones that time where each frame's milliseconds go, on every thread.
+//   {
+//     PROFILE_ZONE ("collide");
+//     ...
+//   } // the zone ends here
+// A zone records its name, start and end in nanoseconds and which zone it is nested in,
+// into a ring buffer owned by the thread it ran on, so threads never wait for each other to record one.
+// Each ring keeps the last { PROFILE_EVENTS_PER_THREAD } zones, older ones are overwritten.
+//
+// Afterwards the rings can be
+// - written out as Chrome trace events (write_profile_trace), open the file in chrome://tracing or ui.perfetto.dev
+//   to see every thread's zones on a timeline
+// - summed into a tree of per phase timings (print_profile_summary), e.g. step > collide > broadphase
+//
+// The zones only exist in builds with SHOT1_PROFILE defined (cmake -DSHOT1_PROFILE=ON).
+// Without it PROFILE_ZONE expands to nothing, so release builds carry no trace of them
+// and the functions below do nothing.
+
+
+/// <summary>
+/// zones each thread keeps, the oldest are overwritten once a thread has recorded more
+/// </summary>
+unsigned const PROFILE_EVENTS_PER_THREAD = 1u << 16;
+
+/// <summary>
+/// most threads that can record zones, zones on any more are dropped
+/// </summary>
+unsigned const PROFILE_MAX_THREADS = 64u;
+
+/// <summary>
+/// deepest zones can be nested, deeper zones are dropped
+/// </summary>
+unsigned const PROFILE_MAX_DEPTH = 32u;
+
+
+/// <summary>
+/// one finished zone
+/// </summary>
+struct profile_event_t
+{
+  char const* name;    // string literal, see PROFILE_ZONE
+  char const* parent;  // name of the zone this one ran inside, nullptr at the top
+  std::uint64_t begin; // nanoseconds since the program started
+  std::uint64_t end;
+  std::uint32_t depth; // 0 at the top
+};
+
+
+#if defined (SHOT1_PROFILE)
+
+/// <summary>
+/// times the scope it is declared in, see PROFILE_ZONE
+/// </summary>
+class profile_zone_t
+{
+public:
+  explicit profile_zone_t (char const* name);
+  ~profile_zone_t ();
+
+  profile_zone_t (profile_zone_t const&) = delete;
+  profile_zone_t& operator = (profile_zone_t const&) = delete;
+
+
+private:
+  std::uint64_t begin;
+  bool recorded; // false if this thread's zones are being dropped
+};
+
+/// <summary>
+/// name the calling thread in the trace, printf style, e.g. ("worker %u", thread)
+/// </summary>
+void set_profile_thread_name (char const* format, ...);
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER (a, b)
+
+// { name } must be a string literal, or live as long as the program
+#define PROFILE_ZONE(name) profile_zone_t const PROFILE_CONCAT (profile_zone_, __LINE__) (name)
+#define PROFILE_THREAD_NAME(...) set_profile_thread_name (__VA_ARGS__)
+
+#else
+
+#define PROFILE_ZONE(name)
+#define PROFILE_THREAD_NAME(...)
+
+#endif
+
+
+/// <summary>
+/// write every zone still in the rings to { path } as Chrome trace event JSON
+/// read the rings once the threads recording into them have stopped, or the newest zones may be half written
+/// </summary>
+/// <returns>false if the file couldn't be written, or the build has no zones</returns>
+bool write_profile_trace (char const* path);
+
+/// <summary>
+/// print the total, count and average time of each zone, summed over every thread, nested under the zones they ran in
+/// </summary>
+void print_profile_summary (std::FILE* file);
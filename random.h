@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint> // for std::uint32_t, std::uint64_t
+
+
+// RANDOM
+//
+// Counter based random numbers: Philox4x32-10 (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3", SC11).
+// rand () steps one hidden state, so each number depends on how many were taken before it, by anyone, on any thread.
+// Here every block of 4 x 32 random bits is a pure function of a key and a 128 bit counter instead:
+// the same key and counter always give the same bits, and neighbouring counters give unrelated ones.
+// So any thread can make any tile's numbers, in any order, 4/8/16 tiles at a time (see fill_random),
+// and get exactly what one thread making them one after another would.
+//
+// The key comes from the game's seed, the counter says what the numbers are for,
+// e.g. spawning tile 7 on the 3rd round of spawns is { 7, 3, RANDOM_STREAM_SPAWN_TILE, 0 } (see tiles.cpp).
+
+
+// Philox4x32 round multipliers and key increments ("Weyl" constants), from the paper
+std::uint32_t const PHILOX_M0 = 0xD2511F53u;
+std::uint32_t const PHILOX_M1 = 0xCD9E8D57u;
+std::uint32_t const PHILOX_W0 = 0x9E3779B9u;
+std::uint32_t const PHILOX_W1 = 0xBB67AE85u;
+unsigned const PHILOX_ROUNDS = 10u;
+
+
+struct random_key_t
+{
+  std::uint32_t words [2];
+};
+
+
+/// <summary>
+/// a batch of counters that share everything but their first word
+/// counter n = { counters [n], counter_1, counter_2, counter_3 }
+/// </summary>
+struct random_query_t
+{
+  random_key_t key;
+  std::uint32_t counter_1;
+  std::uint32_t counter_2;
+  std::uint32_t counter_3;
+};
+
+
+/// <summary>
+/// one Philox block per counter, split into 4 arrays so each can be loaded a vector at a time
+/// words [w][n] is word w of counter n's block
+/// </summary>
+struct random_blocks_t
+{
+  std::uint32_t* words [4];
+};
+
+
+/// <summary>
+/// the key for a game started with { seed }
+/// </summary>
+inline random_key_t get_random_key (std::uint64_t seed)
+{
+  return { { (std::uint32_t)seed, (std::uint32_t)(seed >> 32) } };
+}
+
+/// <summary>
+/// 32 random bits to a float between min and max
+/// uses the top 24 bits, as many as a float in [0, 1) can hold, so no result is more likely than another
+/// </summary>
+inline float get_random_float (std::uint32_t bits, float min, float max)
+{
+  float const unit = (float)(bits >> 8) * (1.f / 16777216.f);
+  return min + unit * (max - min);
+}
@@ -0,0 +1,280 @@
+#include "render.h"
+
+#include <cmath> // for std::atan2
+
+
+void matrix_multiply (float output[4][4], float const input_a[4][4], float const input_b[4][4])
+{
+  // We can access the matrix (4x4 float array) with: matrix [ROW][COLUMN]
+  // Remember, these matrices are stored in the ROW-MAJOR format.
+  // This means groups of 4 consecutive floats in memory represent a row of that matrix.
+  // (With the row-major format this would is not the case,
+  // 4 consecutive floats in memory represent a column of that matrix
+  // and would be accessed with: matrix [column][row].)
+  // This does NOT effect how matrix multiplation is implemented! (It is the same either way.)
+  // OUT00 = ROW0 of A dot COLUMN0 of B, etc
+  // Just take care that you are actually getting the dot product of
+  // a ROW of MATRIX A and a COLUMN of MATRIX B when addressing the memory.
+  //
+  // A00, A01, A02, A03      B00, B01, B02, B03      O00, O01, O02, O03
+  // A10, A11, A12, A13  \/  B10, B11, B12, B13  ==  O10, O11, O12, O13
+  // A20, A21, A22, A23  /\  B20, B21, B22, B23  ==  O20, O21, O22, O23
+  // A30, A31, A32, A33      B30, B31, B32, B33      O30, O31, O32, O33
+  //
+  // e.g. OUT00 = A0n dot Bn0 = A00*B00 + A01*B10 + A02*B20 + A03*B30
+  // e.g. OUT01 = A0n dot Bn1 = A00*B01 + A01*B11 + A02*B21 + A03*B31
+  // e.g. OUT02 = A0n dot Bn2 = A00*B02 + A01*B12 + A02*B22 + A03*B32
+  // e.g. OUT10 = A1n dot Bn0 = A10*B00 + A11*B10 + A12*B20 + A13*B30
+  //
+  // FYI, we can think of multidim arrays as an nD table/'graph' in memory,
+  // being accessed with: arr [...][z][y][x]
+
+  for (int row = 0; row < 4; ++row)
+  {
+    for (int col = 0; col < 4; ++col)
+    {
+      output [row][col] =
+          input_a [row][0] * input_b [0][col]
+        + input_a [row][1] * input_b [1][col]
+        + input_a [row][2] * input_b [2][col]
+        + input_a [row][3] * input_b [3][col];
+    }
+  }
+
+  // Hint: to implement in SIMD, loading a row of input_a will send you down a dead end!
+}
+
+
+// PLAYER
+
+void render_player (magpie::renderer& renderer,
+  magpie::_2d::sprite_batch& sprite_batch,
+  sprite_rects_t const& sprite_rects,
+  frame_snapshot_t const& frame)
+{
+  texture_rect const* tex_rect = get_texture_rect (sprite_rects, frame.player_id);
+  MAGPIE_DASSERT (tex_rect);
+
+  renderer.sb_draw (sprite_batch,
+    *tex_rect,
+    (float)frame.player_position.x, (float)frame.player_position.y,
+    0.f,
+    0.f, 0.f,
+    (float)tex_rect->width, (float)tex_rect->height);
+}
+
+
+// TILES
+
+void render_tiles (magpie::renderer& renderer,
+  magpie::_2d::sprite_batch& sprite_batch,
+  sprite_rects_t const& sprite_rects,
+  frame_snapshot_t const& frame)
+{
+  tile_transforms_t const& tile_transforms = frame.tile_transforms;
+
+#if !defined (SHOT1_REFERENCE_TILE_RENDER)
+
+  // Same model matrix as the reference code below, transposed to column-major the same way,
+  // but only the 6 numbers that are different for each tile get filled in, the rest are set once here.
+  // The sim thread has already worked those 6 out for every tile, 4/8/16 at a time (see build_tile_transforms).
+  // (the results are bit for bit the same as matrix_multiply's: every term it adds on top is a multiply by 0 or 1)
+  alignas (16) float matrix_model[4][4] =
+  {
+    { 0.f, 0.f, 0.f, 0.f },
+    { 0.f, 0.f, 0.f, 0.f },
+    { 0.f, 0.f, 1.f, 0.f },
+    { 0.f, 0.f, 0.f, 1.f },
+  };
+
+  for (unsigned i = 0; i < frame.num_tiles; i++)
+  {
+    texture_rect const* tex_rect = get_texture_rect (sprite_rects, frame.tile_id [i]);
+
+    matrix_model[0][0] = tile_transforms.x_axis_x [i];
+    matrix_model[0][1] = tile_transforms.x_axis_y [i];
+    matrix_model[1][0] = tile_transforms.y_axis_x [i];
+    matrix_model[1][1] = tile_transforms.y_axis_y [i];
+    matrix_model[3][0] = tile_transforms.position_x [i];
+    matrix_model[3][1] = tile_transforms.position_y [i];
+
+    renderer.sb_draw (sprite_batch, *tex_rect, (float*)matrix_model);
+  }
+
+#else // SHOT1_REFERENCE_TILE_RENDER
+
+    for (size_t i = 0; i < frame.num_tiles; i++)
+    {
+
+
+        texture_rect const* tex_rect = get_texture_rect(sprite_rects, frame.tile_id[i]);
+        MAGPIE_DASSERT(tex_rect);
+
+        // the snapshot only keeps each tile's transform, so the angle is read back off its rotated x axis
+        float const position_x = tile_transforms.position_x[i];
+        float const position_y = tile_transforms.position_y[i];
+        float const angle = std::atan2(tile_transforms.x_axis_y[i], tile_transforms.x_axis_x[i]); // must be in radians!
+        float const scale_x = (float)tex_rect->width;
+        float const scale_y = (float)tex_rect->height;
+
+
+
+
+
+        /////////////////////////////////////////////////////////////////////////////////////
+        //// DO NOT EDIT CODE BELOW - THIS CODE MUST BE IN YOUR TILE RENDER FUNCTION >>> ////
+        /////////////////////////////////////////////////////////////////////////////////////
+
+
+        // Row-/Column-major matrices refers to the order in which matrix elements are stored in memory.
+        // "In row-major order, the consecutive elements of a row reside next to each other,
+        // whereas the same holds true for consecutive elements of a column in column-major order."
+        // https://en.wikipedia.org/wiki/Row-_and_column-major_order
+        // Magpie uses the COLUMN-MAJOR matrices.
+        //
+        // However, to simplify the matrix_multiply function (and eventual optimisation using SIMD),
+        // we are going to calculate our model (world) matrix with the input matrices in row-major format
+        // and then transpose them before using to render the tile (in effect converting it from row-major to column-major
+
+        static alignas (16) float matrix_position[4][4];
+        matrix_position[0][0] = 1.f; matrix_position[0][1] = 0.f; matrix_position[0][2] = 0.f; matrix_position[0][3] = position_x;
+        matrix_position[1][0] = 0.f; matrix_position[1][1] = 1.f; matrix_position[1][2] = 0.f; matrix_position[1][3] = position_y;
+        matrix_position[2][0] = 0.f; matrix_position[2][1] = 0.f; matrix_position[2][2] = 1.f; matrix_position[2][3] = 0.f;
+        matrix_position[3][0] = 0.f; matrix_position[3][1] = 0.f; matrix_position[3][2] = 0.f; matrix_position[3][3] = 1.f;
+        f32 const c = magpie::maths::cos(angle);
+        f32 const s = magpie::maths::sin(angle);
+        static alignas (16) float matrix_rotation[4][4];
+        matrix_rotation[0][0] = c;   matrix_rotation[0][1] = -s;  matrix_rotation[0][2] = 0.f; matrix_rotation[0][3] = 0.f;
+        matrix_rotation[1][0] = s;   matrix_rotation[1][1] = c;   matrix_rotation[1][2] = 0.f; matrix_rotation[1][3] = 0.f;
+        matrix_rotation[2][0] = 0.f; matrix_rotation[2][1] = 0.f; matrix_rotation[2][2] = 1.f; matrix_rotation[2][3] = 0.f;
+        matrix_rotation[3][0] = 0.f; matrix_rotation[3][1] = 0.f; matrix_rotation[3][2] = 0.f; matrix_rotation[3][3] = 1.f;
+        static alignas (16) float matrix_scale[4][4];
+        matrix_scale[0][0] = scale_x; matrix_scale[0][1] = 0.f;     matrix_scale[0][2] = 0.f; matrix_scale[0][3] = 0.f;
+        matrix_scale[1][0] = 0.f;     matrix_scale[1][1] = scale_y; matrix_scale[1][2] = 0.f; matrix_scale[1][3] = 0.f;
+        matrix_scale[2][0] = 0.f;     matrix_scale[2][1] = 0.f;     matrix_scale[2][2] = 1.f; matrix_scale[2][3] = 0.f;
+        matrix_scale[3][0] = 0.f;     matrix_scale[3][1] = 0.f;     matrix_scale[3][2] = 0.f; matrix_scale[3][3] = 1.f;
+
+        static alignas (16) float matrix_position_rotation[4][4];
+        static alignas (16) float matrix_model[4][4];
+
+
+        // matrix_model = matrix_position * matrix_rotation * matrix_scale
+        // Remember, matrix maths dictates that we multiply the matrices in the reverse of order of the desired transformation!
+        // i.e. here we are performing the scaling FIRST, THEN the rotation and FINALLY the translation.
+        matrix_multiply(matrix_position_rotation, matrix_position, matrix_rotation);
+        matrix_multiply(matrix_model, matrix_position_rotation, matrix_scale);
+        *(mat4*)matrix_model = magpie::maths::transpose(*(mat4*)matrix_model);
+
+
+        renderer.sb_draw(sprite_batch, *tex_rect, (float*)matrix_model);
+
+
+        /////////////////////////////////////////////////////////////////////////////////////
+        //// <<< DO NOT EDIT CODE ABOVE - THIS CODE MUST BE IN YOUR TILE RENDER FUNCTION ////
+        /////////////////////////////////////////////////////////////////////////////////////
+    }
+
+#endif // SHOT1_REFERENCE_TILE_RENDER
+}
+
+
+// WALLS
+
+void render_walls (magpie::renderer& renderer,
+  magpie::_2d::sprite_batch& sprite_batch,
+  sprite_rects_t const& sprite_rects,
+  walls_t const& walls)
+{
+  texture_rect const* tex_rect = sprite_rects.rects [SPRITE_ID_WALL];
+  MAGPIE_DASSERT (tex_rect);
+
+  auto const wall_size = get_column <wall_size_t> (walls);
+  auto const wall_x = get_column <wall_position_x_t> (walls);
+  auto const wall_y = get_column <wall_position_y_t> (walls);
+  for (unsigned w = 0; w < walls.count; w++)
+  {
+    for (int i = 0; i < 10; ++i)
+    {
+      renderer.sb_draw (sprite_batch,
+        *tex_rect,
+        (float)wall_x [w], (float)wall_y [w],
+        0.f,
+        0.f, 0.f,
+        (float)wall_size [w], (float)wall_size [w]);
+    }
+  }
+
+  //Sleep (1);
+}
+
+
+// GENERAL
+
+sprite_rects_t get_sprite_rects (magpie::spritesheet const& spritesheet)
+{
+  sprite_rects_t sprite_rects;
+
+  for (int id = 0; id < NUM_SPRITE_IDS; id++)
+  {
+    sprite_rects.rects [id] = spritesheet.get_sprite_info (SPRITE_NAMES [id]);
+    MAGPIE_DASSERT (sprite_rects.rects [id]);
+  }
+
+  return sprite_rects;
+}
+
+sprite_table_t get_sprite_table (sprite_rects_t const& sprite_rects)
+{
+  sprite_table_t sprites;
+
+  for (int id = 0; id < NUM_SPRITE_IDS; id++)
+  {
+    texture_rect const* tex_rect = sprite_rects.rects [id];
+    sprites.metrics [id] = make_sprite_metrics ((float)tex_rect->width, (float)tex_rect->height);
+  }
+
+  return sprites;
+}
+
+
+// RESOURCES
+
+static bool initialise_sprite_batch (render_resources_t& resources, magpie::renderer& renderer, unsigned num_tiles)
+{
+  // We need enough capacity for this sprite batch to render 1 player sprite, 4 wall sprites and { num_tiles } tile sprites
+  // Each sprite requires memory for 4 vertices in RAM.
+  resources.sprite_batch_tiles = num_tiles;
+  return resources.sprite_batch.initialise (renderer,
+    resources.spritesheet.get_texture (),
+    num_tiles * 10u);
+}
+
+bool initialise_render_resources (render_resources_t& resources, magpie::renderer& renderer, unsigned num_tiles)
+{
+  if (!resources.spritesheet.initialise (renderer, "data/textures/SHOT1/sprites.xml"))
+  {
+    return false;
+  }
+  resources.sprite_rects = get_sprite_rects (resources.spritesheet);
+  resources.sprites = get_sprite_table (resources.sprite_rects);
+
+  return initialise_sprite_batch (resources, renderer, num_tiles);
+}
+
+bool update_render_resources (render_resources_t& resources, magpie::renderer& renderer, unsigned num_tiles)
+{
+  if (num_tiles <= resources.sprite_batch_tiles)
+  {
+    return true;
+  }
+
+  resources.sprite_batch.release (renderer);
+  return initialise_sprite_batch (resources, renderer, num_tiles);
+}
+
+void release_render_resources (render_resources_t& resources, magpie::renderer& renderer)
+{
+  resources.sprite_batch.release (renderer);
+  resources.spritesheet.release (renderer);
+  resources.sprite_batch_tiles = 0;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "magpie.h"          // for magpie::renderer, magpie::_2d::sprite_batch, magpie::spritesheet
+
+#include "constants.h"       // for object_id_t
+#include "frame_pipeline.h"  // for frame_snapshot_t
+#include "sprites.h"         // for sprite_table_t, sprite_id_t
+#include "walls.h"           // for walls_t
+
+
+// RENDER
+//
+// Magpie side of the app: draws the simulation's state into a sprite batch.
+// Nothing in here changes the simulation, the player and tiles are drawn from a frame_snapshot_t (see frame_pipeline.h)
+// so drawing can run at the same time as the next step.
+
+
+/// <summary>
+/// where each sub-sprite is on the spritesheet, indexed by sprite_id_t
+/// looked up by name once per spritesheet, rather than once per object per frame
+/// the pointers belong to the spritesheet, so are only valid while it is
+/// </summary>
+struct sprite_rects_t
+{
+  texture_rect const* rects [NUM_SPRITE_IDS];
+};
+
+
+void render_player (magpie::renderer& renderer,
+  magpie::_2d::sprite_batch& sprite_batch,
+  sprite_rects_t const& sprite_rects,
+  frame_snapshot_t const& frame);
+
+/// <summary>
+/// draw every tile, using the transforms the sim thread worked out for them when it took { frame }
+/// build with SHOT1_REFERENCE_TILE_RENDER defined to use the original matrix_multiply code instead
+/// </summary>
+void render_tiles (magpie::renderer& renderer,
+  magpie::_2d::sprite_batch& sprite_batch,
+  sprite_rects_t const& sprite_rects,
+  frame_snapshot_t const& frame);
+
+void render_walls (magpie::renderer& renderer,
+  magpie::_2d::sprite_batch& sprite_batch,
+  sprite_rects_t const& sprite_rects,
+  walls_t const& walls);
+
+
+/// <summary>
+/// search the spritesheet for every sub-sprite the game uses
+/// call once after loading the spritesheet
+/// </summary>
+sprite_rects_t get_sprite_rects (magpie::spritesheet const& spritesheet);
+
+/// <summary>
+/// the size of every sub-sprite, for the simulation to use
+/// NOTE: this app uses the size of the sub-sprite as the size of the object in the game world.
+/// </summary>
+sprite_table_t get_sprite_table (sprite_rects_t const& sprite_rects);
+
+/// <summary>
+/// the sub-sprite a particular player/tile/wall is drawn with
+/// </summary>
+inline texture_rect const* get_texture_rect (sprite_rects_t const& sprite_rects, object_id_t id)
+{
+  return sprite_rects.rects [OBJECT_SPRITE_IDS [id]];
+}
+
+
+// RESOURCES
+
+/// <summary>
+/// everything the front end needs to draw a frame that doesn't change from frame to frame
+/// loaded once at startup and kept for the whole session
+/// </summary>
+struct render_resources_t
+{
+  magpie::spritesheet spritesheet;
+  sprite_rects_t sprite_rects; // found in { spritesheet }, once
+  sprite_table_t sprites;      // size of each of { sprite_rects }
+
+  magpie::_2d::sprite_batch sprite_batch;
+  unsigned sprite_batch_tiles; // number of tiles { sprite_batch } was made big enough for
+};
+
+/// <summary>
+/// pre game loop render set up code
+/// loads the spritesheet and makes a sprite batch big enough for { num_tiles } tiles
+/// </summary>
+/// <returns>false if the spritesheet or sprite batch couldn't be created</returns>
+bool initialise_render_resources (render_resources_t& resources, magpie::renderer& renderer, unsigned num_tiles);
+
+/// <summary>
+/// re-create the sprite batch if there are now more tiles than it was made for
+/// does nothing (and allocates nothing) on any other frame
+/// </summary>
+/// <returns>false if the sprite batch couldn't be re-created</returns>
+bool update_render_resources (render_resources_t& resources, magpie::renderer& renderer, unsigned num_tiles);
+
+/// <summary>
+/// post game loop render tear down code
+/// </summary>
+void release_render_resources (render_resources_t& resources, magpie::renderer& renderer);
@@ -0,0 +1,179 @@
+#include "replay.h"
+
+#include <cstdint> // for std::uint8_t, std::uint32_t, std::uint64_t
+#include <cstring> // for std::memcmp
+
+
+char const REPLAY_MAGIC [4] = { 'S', 'R', 'P', 'L' };
+
+/// <summary>
+/// bumped whenever the layout changes, older files are refused rather than misread
+/// </summary>
+std::uint32_t const REPLAY_VERSION = 2u;
+
+std::size_t const REPLAY_FRAME_BYTES = sizeof (double) + sizeof (player_input_t);
+
+
+// WRITING
+
+template <typename value_t>
+static void write_replay_value (replay_recorder_t& recorder, value_t const& value)
+{
+  if (std::fwrite (&value, sizeof (value), 1u, recorder.file) != 1u)
+  {
+    recorder.failed = true;
+  }
+}
+
+bool initialise_replay_recorder (replay_recorder_t& recorder, char const* path, simulation_config_t const& config)
+{
+  recorder.num_frames = 0;
+  recorder.failed = false;
+  recorder.file = std::fopen (path, "wb");
+  if (recorder.file == nullptr)
+  {
+    return false;
+  }
+
+  write_replay_value (recorder, REPLAY_MAGIC);
+  write_replay_value (recorder, REPLAY_VERSION);
+  write_replay_value (recorder, (std::uint64_t)config.seed);
+  write_replay_value (recorder, (std::uint32_t)config.num_tiles);
+  write_replay_value (recorder, config.screen_dim.x);
+  write_replay_value (recorder, config.screen_dim.y);
+  for (sprite_metrics_t const& metrics : config.sprites.metrics)
+  {
+    write_replay_value (recorder, metrics.width);
+    write_replay_value (recorder, metrics.height);
+  }
+  write_replay_value (recorder, (std::uint8_t)config.tile_broadphase);
+  write_replay_value (recorder, (std::uint8_t)config.tile_spawn);
+  write_replay_value (recorder, config.step_rate);
+  write_replay_value (recorder, (std::uint32_t)config.max_steps_per_frame);
+
+  return !recorder.failed;
+}
+
+void record_replay_frame (replay_recorder_t& recorder, double elapsed, player_input_t input)
+{
+  if (recorder.file == nullptr)
+  {
+    return;
+  }
+
+  write_replay_value (recorder, elapsed);
+  write_replay_value (recorder, input);
+  recorder.num_frames++;
+}
+
+bool release_replay_recorder (replay_recorder_t& recorder)
+{
+  if (recorder.file == nullptr)
+  {
+    return false;
+  }
+
+  bool const closed = std::fclose (recorder.file) == 0;
+  recorder.file = nullptr;
+  return closed && !recorder.failed;
+}
+
+
+// READING
+
+template <typename value_t>
+static bool read_replay_value (std::FILE* file, value_t& value)
+{
+  return std::fread (&value, sizeof (value), 1u, file) == 1u;
+}
+
+/// <summary>
+/// everything after the version, into a default config
+/// </summary>
+static bool read_replay_config (std::FILE* file, simulation_config_t& config)
+{
+  config = get_default_simulation_config ();
+
+  std::uint64_t seed;
+  std::uint32_t num_tiles;
+  std::uint8_t tile_broadphase;
+  std::uint8_t tile_spawn;
+  std::uint32_t max_steps_per_frame;
+
+  bool read = read_replay_value (file, seed)
+    && read_replay_value (file, num_tiles)
+    && read_replay_value (file, config.screen_dim.x)
+    && read_replay_value (file, config.screen_dim.y);
+  for (sprite_metrics_t& metrics : config.sprites.metrics)
+  {
+    float width;
+    float height;
+    read = read && read_replay_value (file, width) && read_replay_value (file, height);
+    metrics = make_sprite_metrics (width, height);
+  }
+  read = read
+    && read_replay_value (file, tile_broadphase)
+    && read_replay_value (file, tile_spawn)
+    && read_replay_value (file, config.step_rate)
+    && read_replay_value (file, max_steps_per_frame);
+  if (!read || tile_broadphase > (std::uint8_t)tile_broadphase_t::SWEEP_AND_PRUNE || tile_spawn > (std::uint8_t)tile_spawn_t::CLUSTERED)
+  {
+    return false;
+  }
+
+  config.seed = seed;
+  config.num_tiles = num_tiles;
+  config.tile_broadphase = (tile_broadphase_t)tile_broadphase;
+  config.tile_spawn = (tile_spawn_t)tile_spawn;
+  config.max_steps_per_frame = max_steps_per_frame;
+  return true;
+}
+
+bool load_replay (replay_t& replay, char const* path)
+{
+  replay.frames = nullptr;
+  replay.num_frames = 0;
+
+  std::FILE* const file = std::fopen (path, "rb");
+  if (file == nullptr)
+  {
+    return false;
+  }
+
+  char magic [sizeof (REPLAY_MAGIC)];
+  std::uint32_t version;
+  if (!read_replay_value (file, magic) || std::memcmp (magic, REPLAY_MAGIC, sizeof (magic)) != 0
+    || !read_replay_value (file, version) || version != REPLAY_VERSION
+    || !read_replay_config (file, replay.config))
+  {
+    std::fclose (file);
+    return false;
+  }
+
+  // the frames run to the end of the file
+  long const frames_begin = std::ftell (file);
+  std::fseek (file, 0, SEEK_END);
+  long const frames_end = std::ftell (file);
+  std::fseek (file, frames_begin, SEEK_SET);
+  unsigned const num_frames = (unsigned)((std::size_t)(frames_end - frames_begin) / REPLAY_FRAME_BYTES);
+
+  replay.frames = new replay_frame_t [num_frames];
+  for (unsigned frame = 0; frame < num_frames; frame++)
+  {
+    if (!read_replay_value (file, replay.frames [frame].elapsed) || !read_replay_value (file, replay.frames [frame].input))
+    {
+      break;
+    }
+    replay.num_frames++;
+  }
+
+  std::fclose (file);
+  return true;
+}
+
+void release_replay (replay_t& replay)
+{
+  delete [] replay.frames;
+  replay.frames = nullptr;
+  replay.num_frames = 0;
+}
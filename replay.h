@@ -0,0 +1,88 @@
+#pragma once
+
+#include "player.h"     // for player_input_t
+#include "simulation.h" // for simulation_config_t
+
+#include <cstdio>       // for std::FILE
+
+
+// REPLAY
+//
+// A run of the game recorded to a file, so the simulation can be driven through exactly the same frames again,
+// e.g. to compare the cost of frames between 2 builds, or check the scalar, SIMD and threaded kernels leave the same state behind.
+// Everything that decides what the simulation does is recorded:
+// - the config it started with: seed, tile count, play area, sprite sizes, step rate, broadphase, spawn pattern
+// - each frame's elapsed time and input bitmask
+// The thread count and instruction set aren't, the simulation comes out the same whatever they are,
+// so a replay can be run with any of them and its checksums compared (see get_simulation_checksum).
+//
+// The file is a header then 9 bytes a frame, in the byte order of the machine that wrote it:
+//   "SRPL", version, seed, num_tiles, screen width and height, sprite sizes, tile_broadphase, tile_spawn, step_rate, max_steps_per_frame
+//   per frame: elapsed (double, seconds), input (player_input_t)
+// Frames are written as they happen, with no count up front, so a run that never reaches release_replay_recorder
+// still replays up to its last whole frame.
+
+
+/// <summary>
+/// one frame of a replay, what simulation_t::advance was called with
+/// </summary>
+struct replay_frame_t
+{
+  double elapsed;       // seconds
+  player_input_t input;
+};
+
+
+/// <summary>
+/// writes a replay as the game runs
+/// </summary>
+struct replay_recorder_t
+{
+  std::FILE* file;     // nullptr if it couldn't be opened, frames are then dropped
+  unsigned num_frames; // frames written so far
+  bool failed;         // a write failed, the file is cut short
+};
+
+
+/// <summary>
+/// a replay read back in
+/// </summary>
+struct replay_t
+{
+  // the recorded config, everything else is the default (see get_default_simulation_config)
+  simulation_config_t config;
+
+  replay_frame_t* frames;
+  unsigned num_frames;
+};
+
+
+/// <summary>
+/// pre game loop set up code
+/// create { path } and write the header for a run starting with { config }
+/// </summary>
+/// <returns>false if the file couldn't be written, record_replay_frame then does nothing</returns>
+bool initialise_replay_recorder (replay_recorder_t& recorder, char const* path, simulation_config_t const& config);
+
+/// <summary>
+/// add a frame, in the order they were passed to the simulation
+/// </summary>
+void record_replay_frame (replay_recorder_t& recorder, double elapsed, player_input_t input);
+
+/// <summary>
+/// post game loop tear down code
+/// </summary>
+/// <returns>false if any of the replay couldn't be written</returns>
+bool release_replay_recorder (replay_recorder_t& recorder);
+
+
+/// <summary>
+/// read the replay at { path }, a frame cut short at the end of the file is dropped
+/// </summary>
+/// <returns>false if the file couldn't be read or isn't a replay, { replay } is left empty</returns>
+bool load_replay (replay_t& replay, char const* path);
+
+/// <summary>
+/// releases the frames allocated by load_replay
+/// </summary>
+void release_replay (replay_t& replay);
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>     // for std::uint8_t, std::uint32_t
+#include <immintrin.h> // for __m256, _mm256_*
+
+
+// SIMD AVX2
+//
+// 8 float lanes.
+// Only include this from code compiled for AVX2 (-mavx2 / /arch:AVX2).
+// See simd_scalar.h for what each function does.
+
+
+struct simd_avx2_t
+{
+  static int const LANES = 8;
+
+  using vfloat = __m256;
+  using vmask = __m256; // all bits set in a lane = true
+
+  static vfloat load (float const* memory) { return _mm256_load_ps (memory); }
+  static void store (float* memory, vfloat value) { _mm256_store_ps (memory, value); }
+  static vfloat set1 (float value) { return _mm256_set1_ps (value); }
+
+  static vfloat add (vfloat lhs, vfloat rhs) { return _mm256_add_ps (lhs, rhs); }
+  static vfloat sub (vfloat lhs, vfloat rhs) { return _mm256_sub_ps (lhs, rhs); }
+  static vfloat mul (vfloat lhs, vfloat rhs) { return _mm256_mul_ps (lhs, rhs); }
+  static vfloat min (vfloat lhs, vfloat rhs) { return _mm256_min_ps (lhs, rhs); }
+  static vfloat max (vfloat lhs, vfloat rhs) { return _mm256_max_ps (lhs, rhs); }
+  static vfloat abs (vfloat value) { return _mm256_andnot_ps (_mm256_set1_ps (-0.f), value); }
+  static vfloat neg (vfloat value) { return _mm256_xor_ps (_mm256_set1_ps (-0.f), value); }
+  static vfloat floor (vfloat value) { return _mm256_floor_ps (value); }
+
+  static vmask cmp_lt (vfloat lhs, vfloat rhs) { return _mm256_cmp_ps (lhs, rhs, _CMP_LT_OQ); }
+  static vmask cmp_gt (vfloat lhs, vfloat rhs) { return _mm256_cmp_ps (lhs, rhs, _CMP_GT_OQ); }
+  static vmask mask_and (vmask lhs, vmask rhs) { return _mm256_and_ps (lhs, rhs); }
+  static vmask mask_or (vmask lhs, vmask rhs) { return _mm256_or_ps (lhs, rhs); }
+  static vfloat select (vmask mask, vfloat if_true, vfloat if_false) { return _mm256_blendv_ps (if_false, if_true, mask); }
+  static unsigned mask_bits (vmask mask) { return (unsigned)_mm256_movemask_ps (mask); }
+
+  static vmask load_bytes_eq (std::uint8_t const* memory, std::uint8_t value)
+  {
+    // 8 bytes -> 8 x 32 bit lanes
+    __m256i const bytes = _mm256_cvtepu8_epi32 (_mm_loadl_epi64 ((__m128i const*)memory));
+    return _mm256_castsi256_ps (_mm256_cmpeq_epi32 (bytes, _mm256_set1_epi32 (value)));
+  }
+
+  using vuint = __m256i;
+
+  static vuint load_u (std::uint32_t const* memory) { return _mm256_load_si256 ((__m256i const*)memory); }
+  static void store_u (std::uint32_t* memory, vuint value) { _mm256_store_si256 ((__m256i*)memory, value); }
+  static vuint set1_u (std::uint32_t value) { return _mm256_set1_epi32 ((int)value); }
+
+  static vuint add_u (vuint lhs, vuint rhs) { return _mm256_add_epi32 (lhs, rhs); }
+  static vuint xor_u (vuint lhs, vuint rhs) { return _mm256_xor_si256 (lhs, rhs); }
+  static void mul_wide_u (vuint lhs, vuint rhs, vuint& hi, vuint& lo)
+  {
+    // even lanes, then odd lanes shifted down, see simd_sse2_t
+    __m256i const even = _mm256_mul_epu32 (lhs, rhs);
+    __m256i const odd = _mm256_mul_epu32 (_mm256_srli_epi64 (lhs, 32), _mm256_srli_epi64 (rhs, 32));
+    __m256i const low_halves = _mm256_set1_epi64x (0xffffffff);
+    lo = _mm256_or_si256 (_mm256_and_si256 (even, low_halves), _mm256_slli_epi64 (odd, 32));
+    hi = _mm256_or_si256 (_mm256_srli_epi64 (even, 32), _mm256_andnot_si256 (low_halves, odd));
+  }
+};
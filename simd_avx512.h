@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>     // for std::uint8_t, std::uint32_t
+#include <immintrin.h> // for __m512, _mm512_*
+
+
+// SIMD AVX-512
+//
+// 16 float lanes, a whole cache line per register.
+// Only include this from code compiled for AVX-512 (-mavx512f / /arch:AVX512).
+// See simd_scalar.h for what each function does.
+
+
+struct simd_avx512_t
+{
+  static int const LANES = 16;
+
+  using vfloat = __m512;
+  using vmask = __mmask16; // 1 bit per lane
+
+  static vfloat load (float const* memory) { return _mm512_load_ps (memory); }
+  static void store (float* memory, vfloat value) { _mm512_store_ps (memory, value); }
+  static vfloat set1 (float value) { return _mm512_set1_ps (value); }
+
+  static vfloat add (vfloat lhs, vfloat rhs) { return _mm512_add_ps (lhs, rhs); }
+  static vfloat sub (vfloat lhs, vfloat rhs) { return _mm512_sub_ps (lhs, rhs); }
+  static vfloat mul (vfloat lhs, vfloat rhs) { return _mm512_mul_ps (lhs, rhs); }
+  static vfloat min (vfloat lhs, vfloat rhs) { return _mm512_min_ps (lhs, rhs); }
+  static vfloat max (vfloat lhs, vfloat rhs) { return _mm512_max_ps (lhs, rhs); }
+  static vfloat abs (vfloat value) { return _mm512_abs_ps (value); }
+  static vfloat neg (vfloat value) { return _mm512_castsi512_ps (_mm512_xor_si512 (_mm512_castps_si512 (value), _mm512_set1_epi32 ((int)0x80000000u))); }
+  static vfloat floor (vfloat value) { return _mm512_roundscale_ps (value, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+
+  static vmask cmp_lt (vfloat lhs, vfloat rhs) { return _mm512_cmp_ps_mask (lhs, rhs, _CMP_LT_OQ); }
+  static vmask cmp_gt (vfloat lhs, vfloat rhs) { return _mm512_cmp_ps_mask (lhs, rhs, _CMP_GT_OQ); }
+  static vmask mask_and (vmask lhs, vmask rhs) { return (vmask)(lhs & rhs); }
+  static vmask mask_or (vmask lhs, vmask rhs) { return (vmask)(lhs | rhs); }
+  static vfloat select (vmask mask, vfloat if_true, vfloat if_false) { return _mm512_mask_blend_ps (mask, if_false, if_true); }
+  static unsigned mask_bits (vmask mask) { return (unsigned)mask; }
+
+  static vmask load_bytes_eq (std::uint8_t const* memory, std::uint8_t value)
+  {
+    // 16 bytes -> 16 x 32 bit lanes
+    __m512i const bytes = _mm512_cvtepu8_epi32 (_mm_load_si128 ((__m128i const*)memory));
+    return _mm512_cmpeq_epi32_mask (bytes, _mm512_set1_epi32 (value));
+  }
+
+  using vuint = __m512i;
+
+  static vuint load_u (std::uint32_t const* memory) { return _mm512_load_si512 (memory); }
+  static void store_u (std::uint32_t* memory, vuint value) { _mm512_store_si512 (memory, value); }
+  static vuint set1_u (std::uint32_t value) { return _mm512_set1_epi32 ((int)value); }
+
+  static vuint add_u (vuint lhs, vuint rhs) { return _mm512_add_epi32 (lhs, rhs); }
+  static vuint xor_u (vuint lhs, vuint rhs) { return _mm512_xor_si512 (lhs, rhs); }
+  static void mul_wide_u (vuint lhs, vuint rhs, vuint& hi, vuint& lo)
+  {
+    // even lanes, then odd lanes shifted down, see simd_sse2_t
+    __m512i const even = _mm512_mul_epu32 (lhs, rhs);
+    __m512i const odd = _mm512_mul_epu32 (_mm512_srli_epi64 (lhs, 32), _mm512_srli_epi64 (rhs, 32));
+    __m512i const low_halves = _mm512_set1_epi64 (0xffffffff);
+    lo = _mm512_or_si512 (_mm512_and_si512 (even, low_halves), _mm512_slli_epi64 (odd, 32));
+    hi = _mm512_or_si512 (_mm512_srli_epi64 (even, 32), _mm512_andnot_si512 (low_halves, odd));
+  }
+};
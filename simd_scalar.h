@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cmath>   // for std::abs, std::floor
+#include <cstdint> // for std::uint8_t, std::uint32_t, std::uint64_t
+
+
+// SIMD SCALAR
+//
+// 1 lane, plain C++.
+// The reference every other simd_*_t is checked against, and the fallback for CPUs without SSE2.
+// Every simd_*_t has the same members, so kernels can be written once (see tile_kernels.inl).
+
+
+struct simd_scalar_t
+{
+  static int const LANES = 1;
+
+  using vfloat = float;
+  using vmask = bool;
+
+  // memory must be aligned to LANES floats
+  static vfloat load (float const* memory) { return *memory; }
+  static void store (float* memory, vfloat value) { *memory = value; }
+  // same value in every lane
+  static vfloat set1 (float value) { return value; }
+
+  static vfloat add (vfloat lhs, vfloat rhs) { return lhs + rhs; }
+  static vfloat sub (vfloat lhs, vfloat rhs) { return lhs - rhs; }
+  static vfloat mul (vfloat lhs, vfloat rhs) { return lhs * rhs; }
+  static vfloat min (vfloat lhs, vfloat rhs) { return lhs < rhs ? lhs : rhs; } // same NaN behaviour as minps
+  static vfloat max (vfloat lhs, vfloat rhs) { return lhs > rhs ? lhs : rhs; }
+  static vfloat abs (vfloat value) { return std::abs (value); }
+  static vfloat neg (vfloat value) { return -value; }
+  static vfloat floor (vfloat value) { return std::floor (value); }
+
+  static vmask cmp_lt (vfloat lhs, vfloat rhs) { return lhs < rhs; }
+  static vmask cmp_gt (vfloat lhs, vfloat rhs) { return lhs > rhs; }
+  static vmask mask_and (vmask lhs, vmask rhs) { return lhs && rhs; }
+  static vmask mask_or (vmask lhs, vmask rhs) { return lhs || rhs; }
+  // per lane: mask ? if_true : if_false
+  static vfloat select (vmask mask, vfloat if_true, vfloat if_false) { return mask ? if_true : if_false; }
+  // bit n set = lane n true
+  static unsigned mask_bits (vmask mask) { return mask ? 1u : 0u; }
+
+  // LANES bytes, lane n true where byte n == value
+  static vmask load_bytes_eq (std::uint8_t const* memory, std::uint8_t value) { return *memory == value; }
+
+  // 32 bit unsigned lanes, wrapping on overflow
+
+  using vuint = std::uint32_t;
+
+  // memory must be aligned to LANES uint32s
+  static vuint load_u (std::uint32_t const* memory) { return *memory; }
+  static void store_u (std::uint32_t* memory, vuint value) { *memory = value; }
+  static vuint set1_u (std::uint32_t value) { return value; }
+
+  static vuint add_u (vuint lhs, vuint rhs) { return lhs + rhs; }
+  static vuint xor_u (vuint lhs, vuint rhs) { return lhs ^ rhs; }
+  // the full 64 bit product of each lane, split into its high and low 32 bits
+  static void mul_wide_u (vuint lhs, vuint rhs, vuint& hi, vuint& lo)
+  {
+    std::uint64_t const product = (std::uint64_t)lhs * rhs;
+    hi = (vuint)(product >> 32);
+    lo = (vuint)product;
+  }
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>     // for std::uint8_t, std::uint32_t
+#include <cstring>     // for std::memcpy
+#include <immintrin.h> // for __m128, _mm_*
+
+
+// SIMD SSE2
+//
+// 4 float lanes. SSE2 is part of x86-64, so every machine we run on has it.
+// See simd_scalar.h for what each function does.
+
+
+struct simd_sse2_t
+{
+  static int const LANES = 4;
+
+  using vfloat = __m128;
+  using vmask = __m128; // all bits set in a lane = true
+
+  static vfloat load (float const* memory) { return _mm_load_ps (memory); }
+  static void store (float* memory, vfloat value) { _mm_store_ps (memory, value); }
+  static vfloat set1 (float value) { return _mm_set1_ps (value); }
+
+  static vfloat add (vfloat lhs, vfloat rhs) { return _mm_add_ps (lhs, rhs); }
+  static vfloat sub (vfloat lhs, vfloat rhs) { return _mm_sub_ps (lhs, rhs); }
+  static vfloat mul (vfloat lhs, vfloat rhs) { return _mm_mul_ps (lhs, rhs); }
+  static vfloat min (vfloat lhs, vfloat rhs) { return _mm_min_ps (lhs, rhs); }
+  static vfloat max (vfloat lhs, vfloat rhs) { return _mm_max_ps (lhs, rhs); }
+  static vfloat abs (vfloat value) { return _mm_andnot_ps (_mm_set1_ps (-0.f), value); }
+  static vfloat neg (vfloat value) { return _mm_xor_ps (_mm_set1_ps (-0.f), value); }
+  static vfloat floor (vfloat value)
+  {
+    // SSE2 has no round instruction: truncate towards 0, then step down 1 where that rounded up (negative values)
+    // only valid for |value| < 2^31, plenty for anything we floor
+    __m128 const truncated = _mm_cvtepi32_ps (_mm_cvttps_epi32 (value));
+    return _mm_sub_ps (truncated, _mm_and_ps (_mm_cmpgt_ps (truncated, value), _mm_set1_ps (1.f)));
+  }
+
+  static vmask cmp_lt (vfloat lhs, vfloat rhs) { return _mm_cmplt_ps (lhs, rhs); }
+  static vmask cmp_gt (vfloat lhs, vfloat rhs) { return _mm_cmpgt_ps (lhs, rhs); }
+  static vmask mask_and (vmask lhs, vmask rhs) { return _mm_and_ps (lhs, rhs); }
+  static vmask mask_or (vmask lhs, vmask rhs) { return _mm_or_ps (lhs, rhs); }
+  static vfloat select (vmask mask, vfloat if_true, vfloat if_false)
+  {
+    return _mm_or_ps (_mm_and_ps (mask, if_true), _mm_andnot_ps (mask, if_false));
+  }
+  static unsigned mask_bits (vmask mask) { return (unsigned)_mm_movemask_ps (mask); }
+
+  static vmask load_bytes_eq (std::uint8_t const* memory, std::uint8_t value)
+  {
+    // compare 4 bytes, then widen each 0x00/0xff result to a 32 bit lane
+    int bytes;
+    std::memcpy (&bytes, memory, sizeof (bytes));
+    __m128i equal = _mm_cmpeq_epi8 (_mm_cvtsi32_si128 (bytes), _mm_set1_epi8 ((char)value));
+    equal = _mm_unpacklo_epi8 (equal, equal);
+    equal = _mm_unpacklo_epi16 (equal, equal);
+    return _mm_castsi128_ps (equal);
+  }
+
+  using vuint = __m128i;
+
+  static vuint load_u (std::uint32_t const* memory) { return _mm_load_si128 ((__m128i const*)memory); }
+  static void store_u (std::uint32_t* memory, vuint value) { _mm_store_si128 ((__m128i*)memory, value); }
+  static vuint set1_u (std::uint32_t value) { return _mm_set1_epi32 ((int)value); }
+
+  static vuint add_u (vuint lhs, vuint rhs) { return _mm_add_epi32 (lhs, rhs); }
+  static vuint xor_u (vuint lhs, vuint rhs) { return _mm_xor_si128 (lhs, rhs); }
+  static void mul_wide_u (vuint lhs, vuint rhs, vuint& hi, vuint& lo)
+  {
+    // mul_epu32 only multiplies the even lanes, each into a 64 bit result, so shift the odd lanes down and do them too
+    __m128i const even = _mm_mul_epu32 (lhs, rhs);
+    __m128i const odd = _mm_mul_epu32 (_mm_srli_epi64 (lhs, 32), _mm_srli_epi64 (rhs, 32));
+    __m128i const low_halves = _mm_set1_epi64x (0xffffffff);
+    lo = _mm_or_si128 (_mm_and_si128 (even, low_halves), _mm_slli_epi64 (odd, 32));
+    hi = _mm_or_si128 (_mm_srli_epi64 (even, 32), _mm_andnot_si128 (low_halves, odd));
+  }
+};
@@ -0,0 +1,181 @@
+#include "simulation.h"
+
+#include "collision.h" // for resolve_collisions
+#include "profiler.h"  // for PROFILE_ZONE
+
+#include <cmath>       // for std::fmod
+#include <cstddef>     // for std::size_t
+
+
+void simulation_t::step (double elapsed, player_input_t input)
+{
+  PROFILE_ZONE ("step");
+
+  // PLAYER
+  {
+    PROFILE_ZONE ("update players");
+    update_players (players, elapsed, input);
+  }
+
+  // TILES
+  {
+    PROFILE_ZONE ("update tiles");
+    tiles.update (elapsed, jobs);
+  }
+
+  // COLLISIONS
+  {
+    PROFILE_ZONE ("collide");
+    if (config.tile_broadphase == tile_broadphase_t::GRID)
+    {
+      {
+        PROFILE_ZONE ("broadphase");
+        build_spatial_grid (grid, tiles, config.sprites);
+      }
+      PROFILE_ZONE ("tile v tile");
+      resolve_tile_collisions (tiles, grid);
+    }
+    else if (config.tile_broadphase == tile_broadphase_t::SWEEP_AND_PRUNE)
+    {
+      {
+        PROFILE_ZONE ("broadphase");
+        update_sweep_and_prune (sap, tiles, config.sprites);
+      }
+      PROFILE_ZONE ("tile v tile");
+      resolve_tile_collisions (tiles, sap);
+    }
+
+    {
+      PROFILE_ZONE ("player & walls");
+      resolve_collisions (config.sprites,
+        players, tiles, walls, arena, jobs);
+    }
+  }
+
+  // SPAWN
+  {
+    PROFILE_ZONE ("spawn");
+    check_player_needs_replacing (players);
+    replace_expired_tiles (tiles, arena, jobs);
+  }
+
+  // nothing allocated this step is needed past here
+  reset_frame_arena (arena);
+}
+
+unsigned simulation_t::advance (double elapsed, player_input_t input)
+{
+  PROFILE_ZONE ("advance");
+
+  double const step_secs = 1.0 / config.step_rate;
+
+  accumulator += elapsed;
+
+  unsigned steps = 0;
+  while (accumulator >= step_secs && steps < config.max_steps_per_frame)
+  {
+    step (step_secs, input);
+    accumulator -= step_secs;
+    steps++;
+  }
+
+  // still behind after the most steps we are allowed, e.g. the window was dragged or a breakpoint was hit
+  // let the game slow down for this frame rather than try to catch up on the next ones
+  if (accumulator >= step_secs)
+  {
+    accumulator = std::fmod (accumulator, step_secs);
+  }
+
+  return steps;
+}
+
+double simulation_t::get_interpolation () const
+{
+  return accumulator * config.step_rate;
+}
+
+
+// GENERAL
+
+simulation_config_t get_default_simulation_config ()
+{
+  simulation_config_t config;
+  config.num_tiles = NUM_TILES;
+  config.screen_dim = { (double)SCREEN_WIDTH, (double)SCREEN_HEIGHT, 0.0, 0.0 };
+  config.sprites = SPRITE_TABLE_DEFAULT;
+  config.tile_broadphase = tile_broadphase_t::NONE;
+  config.tile_spawn = tile_spawn_t::UNIFORM;
+  config.num_threads = 0;
+  config.seed = 0;
+  config.step_rate = 60.0;
+  config.max_steps_per_frame = 8;
+
+  return config;
+}
+
+void initialise_simulation (simulation_t& simulation, simulation_config_t const& config)
+{
+  simulation.config = config;
+
+  initialise_job_system (simulation.jobs, config.num_threads);
+  initialise_players (simulation.players);
+  simulation.accumulator = 0.0;
+  // room for every list a step makes, even if every tile is eaten and respawned in it:
+  // eaten and expired indices, and 4 random words per respawn
+  // the arena grows itself if that is ever not enough
+  initialise_frame_arena (simulation.arena, config.num_tiles * 6u * sizeof (std::uint32_t));
+  initialise_tiles (simulation.tiles, config.num_tiles, config.seed, config.tile_spawn, simulation.arena, simulation.jobs);
+  reset_frame_arena (simulation.arena);
+  simulation.walls = initialise_walls (config.screen_dim);
+  initialise_spatial_grid (simulation.grid, config.screen_dim, config.sprites, simulation.tiles.capacity);
+  initialise_sweep_and_prune (simulation.sap, simulation.tiles.count);
+}
+
+void release_simulation (simulation_t& simulation)
+{
+  release_tiles (simulation.tiles);
+  release_players (simulation.players);
+  release_walls (simulation.walls);
+  release_spatial_grid (simulation.grid);
+  release_sweep_and_prune (simulation.sap);
+  release_frame_arena (simulation.arena);
+  release_job_system (simulation.jobs);
+}
+
+
+// CHECKSUM
+
+// 64 bit FNV-1a, a byte at a time
+std::uint64_t const CHECKSUM_OFFSET_BASIS = 0xcbf29ce484222325ull;
+std::uint64_t const CHECKSUM_PRIME = 0x100000001b3ull;
+
+static void add_to_checksum (std::uint64_t& checksum, void const* data, std::size_t size)
+{
+  unsigned char const* const bytes = (unsigned char const*)data;
+  for (std::size_t i = 0; i < size; i++)
+  {
+    checksum = (checksum ^ bytes [i]) * CHECKSUM_PRIME;
+  }
+}
+
+std::uint64_t get_simulation_checksum (simulation_t const& simulation)
+{
+  std::uint64_t checksum = CHECKSUM_OFFSET_BASIS;
+
+  // only the entities in use, the padding past { count } isn't part of the state
+  unsigned const num_tiles = simulation.tiles.count;
+  for_each_soa_column (simulation.tiles, [&] (auto const* column)
+  {
+    add_to_checksum (checksum, column, num_tiles * sizeof (*column));
+  });
+  add_to_checksum (checksum, &simulation.tiles.spawn_round, sizeof (simulation.tiles.spawn_round));
+
+  unsigned const num_players = simulation.players.count;
+  for_each_soa_column (simulation.players, [&] (auto const* column)
+  {
+    add_to_checksum (checksum, column, num_players * sizeof (*column));
+  });
+
+  add_to_checksum (checksum, &simulation.accumulator, sizeof (simulation.accumulator));
+  return checksum;
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "frame_arena.h"     // for frame_arena_t
+#include "job_system.h"      // for job_system_t
+#include "player.h"          // for players_t, player_input_t
+#include "spatial_grid.h"    // for spatial_grid_t
+#include "sprites.h"         // for sprite_table_t
+#include "sweep_and_prune.h" // for sweep_and_prune_t
+#include "tiles.h"           // for tiles_t
+#include "utility.h"         // for vector4
+#include "walls.h"           // for walls_t
+
+#include <cstdint>           // for std::uint64_t
+
+
+// SIMULATION
+//
+// Everything the game needs to run one frame, with no dependency on Magpie.
+// The graphical front end (main.cpp) polls input, steps the simulation and then renders its state.
+// Headless drivers (benchmarks, soak tests...) step it without a window at all.
+//
+// The simulation moves in fixed steps of 1 / { step_rate } seconds, whatever the frame rate.
+// advance adds each frame's time to an accumulator and runs as many whole steps as fit,
+// e.g. at 60 steps a second a 144Hz display gets a step on roughly every other frame, a 30Hz one gets 2 a frame.
+// The time left over (less than a step) is how far the renderer is between the last 2 steps,
+// it draws the player and tiles that far between where they were and where they are (see get_interpolation).
+// Every step being the same length keeps the collisions behaving the same however fast the game runs,
+// a slow frame can no longer move a tile or the player further in one go than a step's worth.
+
+
+/// <summary>
+/// how tile v tile collisions are found, if at all
+/// the original game has none, tiles pass straight through each other
+/// </summary>
+enum class tile_broadphase_t
+{
+  NONE,
+  GRID,            // uniform grid, rebuilt every frame (see spatial_grid.h)
+  SWEEP_AND_PRUNE, // sorted endpoint list, kept between frames (see sweep_and_prune.h)
+};
+
+
+struct simulation_config_t
+{
+  unsigned num_tiles;    // number of tiles in the game, chosen at startup
+  vector4 screen_dim;    // size of the play area, origin is in the centre
+  sprite_table_t sprites; // size of each object in the game world
+  tile_broadphase_t tile_broadphase;
+  tile_spawn_t tile_spawn; // where tiles are placed, anywhere or in clusters
+  unsigned num_threads;  // threads the per tile stages are split over, 0 = one per hardware thread
+  std::uint64_t seed;    // every random number in the game comes from this, the same seed plays out the same way
+
+  double step_rate;              // steps per second
+  unsigned max_steps_per_frame;  // a frame longer than this many steps drops the rest, rather than falling ever further behind
+};
+
+
+struct simulation_t
+{
+  simulation_config_t config;
+
+  players_t players;
+  tiles_t tiles;
+  walls_t walls;
+
+  spatial_grid_t grid;
+  sweep_and_prune_t sap;
+
+  // also used by the front end to build the tile transforms between steps
+  job_system_t jobs;
+
+  // scratch lists that only last one step, e.g. the tiles eaten or respawned, reset at the end of every step
+  // its peak is the most scratch memory any step has needed
+  frame_arena_t arena;
+
+  double accumulator; // time passed that hasn't been stepped yet, less than a step after advance
+
+
+  /// <summary>
+  /// move the simulation on by a frame's worth of time, in as many fixed steps as fit
+  /// at most { config.max_steps_per_frame }, any more time than that is dropped
+  /// </summary>
+  /// <param name="elapsed">frame time, in seconds</param>
+  /// <param name="input">directions the user is holding this frame, used for every step</param>
+  /// <returns>the number of steps run, may be 0</returns>
+  unsigned advance (double elapsed, player_input_t input);
+
+  /// <summary>
+  /// how far the time advanced so far is between the last 2 steps, in [0, 1] (1 only through rounding)
+  /// the renderer draws things this far from where they were before the last step to where they are now
+  /// </summary>
+  double get_interpolation () const;
+
+
+  /// <summary>
+  /// advance the simulation by one step
+  /// update player & tiles, resolve collisions, replace player & expired tiles
+  /// the step's scratch memory comes from { arena } and is dropped at the end
+  /// the per tile stages are split over { jobs }, and give the same result however many threads it has
+  /// </summary>
+  /// <param name="elapsed">step time, in seconds</param>
+  /// <param name="input">directions the user is holding this frame</param>
+  void step (double elapsed, player_input_t input);
+};
+
+
+/// <summary>
+/// the config the game has always run with, { NUM_TILES } tiles in a { SCREEN_WIDTH } x { SCREEN_HEIGHT } play area
+/// </summary>
+simulation_config_t get_default_simulation_config ();
+
+/// <summary>
+/// pre game loop simulation set up code
+/// </summary>
+void initialise_simulation (simulation_t& simulation, simulation_config_t const& config);
+
+/// <summary>
+/// post game loop simulation tear down code
+/// </summary>
+void release_simulation (simulation_t& simulation);
+
+/// <summary>
+/// a hash of the simulation's state: every tile and player, and the time not yet stepped
+/// 2 runs with the same config and frames (see replay.h) have the same checksum after each frame,
+/// whatever thread count or instruction set they ran with
+/// </summary>
+std::uint64_t get_simulation_checksum (simulation_t const& simulation);
@@ -0,0 +1,222 @@
+#pragma once
+
+#include "utility.h"   // for aligned_allocate, aligned_release, CACHE_LINE_SIZE
+
+#include <algorithm>   // for std::max, std::min
+#include <cstring>     // for std::memcpy, std::memset
+#include <memory>      // for std::assume_aligned
+#include <tuple>       // for std::tuple, std::get
+#include <type_traits> // for std::conditional_t, std::is_trivially_copyable_v, std::remove_pointer_t
+
+
+// SOA POOL
+//
+// Storage for one type of entity (tiles, walls...) as a structure of arrays.
+// Each field is a column, an array of that field for every entity, rather than each entity being a struct of fields,
+// so a pass that only needs 2 fields only pulls those 2 through the cache, a whole vector of entities at a time.
+//
+// A field is an empty tag type that names its value type, e.g.
+//   struct tile_pos_x_t { using value_t = float; };
+// and a pool is a list of fields, e.g. soa_pool_t <tile_pos_x_t, tile_pos_y_t>.
+// get_column <tile_pos_x_t> (pool) is then that field's column, a typed view that SIMD kernels load from.
+//
+// Every column starts on a cache line and is { capacity } long, a whole number of cache lines of its smallest field:
+// kernels can run whole vectors up to { capacity } without a scalar tail,
+// and threads working on chunks that start on a cache line never write to the same one.
+// Entities past { count } are padding. The pool zeroes them when the columns grow, but after that they are scratch:
+// a kernel running whole vectors may write to the padding lanes of its last one (e.g. update_tiles counts their lifetime down),
+// so nothing should read them. An entity is zeroed again whenever the pool hands it out (resize_soa_pool, push_back_soa_pool).
+//
+// Entities live at [0, count). Removing one moves the last into its place (swap_remove_soa_pool),
+// so the columns never have holes, but indices are not stable across a remove.
+
+
+/// <summary>
+/// how precise an entity type's real numbers are, picked per entity type at compile time
+/// </summary>
+enum class precision_t
+{
+  SINGLE, // float, 16 to an AVX-512 register
+  DOUBLE,
+};
+
+template <precision_t PRECISION>
+using real_t = std::conditional_t <PRECISION == precision_t::DOUBLE, double, float>;
+
+
+/// <summary>
+/// one column of a pool, [0, capacity)
+/// </summary>
+template <typename value_t>
+struct soa_column_t
+{
+  value_t* data; // aligned to a cache line
+
+  value_t& operator [] (unsigned index) const { return data [index]; }
+  // the address of entity { index }, e.g. simd::load (pos_x + i)
+  value_t* operator + (unsigned index) const { return std::assume_aligned <CACHE_LINE_SIZE> (data) + index; }
+};
+
+
+template <typename field_t>
+struct soa_storage_t
+{
+  typename field_t::value_t* data;
+};
+
+
+template <typename... fields_t>
+struct soa_pool_t
+{
+  static_assert (sizeof... (fields_t) > 0u, "a pool needs at least one field");
+  static_assert ((std::is_trivially_copyable_v <typename fields_t::value_t> && ...), "columns are copied and zeroed as bytes");
+
+  /// <summary>
+  /// capacity is always a multiple of this many entities, a cache line of the smallest field
+  /// </summary>
+  static constexpr unsigned GRANULARITY = (unsigned)(CACHE_LINE_SIZE / std::min ({ sizeof (typename fields_t::value_t)... }));
+
+  unsigned count;    // entities in use, [0, count)
+  unsigned capacity; // entities there is room for in every column
+
+  // a distinct type per field, so two fields with the same value type are still told apart
+  std::tuple <soa_storage_t <fields_t>...> columns;
+};
+
+
+/// <summary>
+/// the column for { field_t }
+/// </summary>
+template <typename field_t, typename... fields_t>
+soa_column_t <typename field_t::value_t> get_column (soa_pool_t <fields_t...>& pool)
+{
+  return { std::get <soa_storage_t <field_t>> (pool.columns).data };
+}
+
+template <typename field_t, typename... fields_t>
+soa_column_t <typename field_t::value_t const> get_column (soa_pool_t <fields_t...> const& pool)
+{
+  return { std::get <soa_storage_t <field_t>> (pool.columns).data };
+}
+
+
+/// <summary>
+/// make every column at least { capacity } long, rounded up to the pool's granularity
+/// the entities in use are copied over, the rest is zeroed
+/// </summary>
+template <typename... fields_t>
+void reserve_soa_pool (soa_pool_t <fields_t...>& pool, unsigned capacity)
+{
+  unsigned const granularity = soa_pool_t <fields_t...>::GRANULARITY;
+  capacity = (capacity + granularity - 1u) / granularity * granularity;
+  if (capacity <= pool.capacity)
+  {
+    return;
+  }
+
+  auto const grow = [&] (auto& column)
+  {
+    using value_t = std::remove_pointer_t <decltype (column.data)>;
+    value_t* const data = (value_t*)aligned_allocate (capacity * sizeof (value_t));
+    if (column.data != nullptr)
+    {
+      std::memcpy (data, column.data, pool.count * sizeof (value_t));
+      aligned_release (column.data);
+    }
+    std::memset (data + pool.count, 0, (capacity - pool.count) * sizeof (value_t));
+    column.data = data;
+  };
+  std::apply ([&] (auto&... columns) { (grow (columns), ...); }, pool.columns);
+
+  pool.capacity = capacity;
+}
+
+/// <summary>
+/// pre game loop set up code
+/// room for { capacity } entities, none in use
+/// </summary>
+template <typename... fields_t>
+void initialise_soa_pool (soa_pool_t <fields_t...>& pool, unsigned capacity)
+{
+  pool.count = 0;
+  pool.capacity = 0;
+  std::apply ([] (auto&... columns) { ((columns.data = nullptr), ...); }, pool.columns);
+
+  reserve_soa_pool (pool, capacity);
+}
+
+/// <summary>
+/// post game loop tear down code
+/// </summary>
+template <typename... fields_t>
+void release_soa_pool (soa_pool_t <fields_t...>& pool)
+{
+  std::apply ([] (auto&... columns) { ((aligned_release (columns.data), columns.data = nullptr), ...); }, pool.columns);
+  pool.count = 0;
+  pool.capacity = 0;
+}
+
+/// <summary>
+/// { count } entities in use, growing the columns if they are too short
+/// entities added on the end are all zero
+/// </summary>
+template <typename... fields_t>
+void resize_soa_pool (soa_pool_t <fields_t...>& pool, unsigned count)
+{
+  reserve_soa_pool (pool, count);
+
+  // the padding being handed out may have been written to, see above
+  if (count > pool.count)
+  {
+    std::apply ([&] (auto&... columns)
+    {
+      ((std::memset (columns.data + pool.count, 0, (count - pool.count) * sizeof (*columns.data))), ...);
+    }, pool.columns);
+  }
+  pool.count = count;
+}
+
+/// <summary>
+/// add one entity on the end, all zero, doubling the columns if they are full
+/// </summary>
+/// <returns>its index</returns>
+template <typename... fields_t>
+unsigned push_back_soa_pool (soa_pool_t <fields_t...>& pool)
+{
+  if (pool.count == pool.capacity)
+  {
+    reserve_soa_pool (pool, std::max (pool.capacity * 2u, soa_pool_t <fields_t...>::GRANULARITY));
+  }
+
+  unsigned const index = pool.count++;
+  std::apply ([&] (auto&... columns) { ((std::memset (columns.data + index, 0, sizeof (*columns.data))), ...); }, pool.columns);
+  return index;
+}
+
+/// <summary>
+/// remove entity { index } by moving the last entity into its place
+/// the last entity's index changes to { index }, every other index stays the same
+/// </summary>
+template <typename... fields_t>
+void swap_remove_soa_pool (soa_pool_t <fields_t...>& pool, unsigned index)
+{
+  unsigned const last = pool.count - 1u;
+  std::apply ([&] (auto&... columns)
+  {
+    ((columns.data [index] = columns.data [last]), ...);
+  }, pool.columns);
+  pool.count = last;
+}
+
+/// <summary>
+/// call visit (data) with each column's data, in the order the fields are listed, e.g. to hash or save them
+/// </summary>
+template <typename visit_t, typename... fields_t>
+void for_each_soa_column (soa_pool_t <fields_t...> const& pool, visit_t const& visit)
+{
+  auto const visit_column = [&] (auto const& column)
+  {
+    visit ((std::remove_pointer_t <decltype (column.data)> const*)column.data);
+  };
+  std::apply ([&] (auto const&... columns) { (visit_column (columns), ...); }, pool.columns);
+}
@@ -0,0 +1,110 @@
+#include "spatial_grid.h"
+
+#include "tiles.h"   // for tiles_t
+
+#include <algorithm> // for std::max, std::min
+#include <cmath>     // for std::ceil
+
+
+static float get_cell_size (sprite_table_t const& sprites)
+{
+  // 2 tiles can only overlap if their centres are closer than the sum of their half sizes,
+  // which is never more than the biggest tile's full size
+  sprite_metrics_t const& tile_normal = get_sprite_metrics (sprites, SPRITE_ID_TILE_NORMAL);
+  sprite_metrics_t const& tile_wide = get_sprite_metrics (sprites, SPRITE_ID_TILE_WIDE);
+  return std::max ({ tile_normal.width, tile_normal.height, tile_wide.width, tile_wide.height });
+}
+
+static void initialise_cells (spatial_grid_t& grid, float cell_size)
+{
+  grid.cell_size = cell_size;
+  grid.origin_x = (float)(grid.screen_dim.x / -2.0);
+  grid.origin_y = (float)(grid.screen_dim.y / -2.0);
+  grid.cells_x = std::max (1u, (unsigned)std::ceil (grid.screen_dim.x / cell_size));
+  grid.cells_y = std::max (1u, (unsigned)std::ceil (grid.screen_dim.y / cell_size));
+
+  unsigned const num_cells = grid.cells_x * grid.cells_y;
+  grid.cell_start = (unsigned*)aligned_allocate ((num_cells + 1u) * sizeof (unsigned));
+  grid.cell_cursor = (unsigned*)aligned_allocate (num_cells * sizeof (unsigned));
+}
+
+static void release_cells (spatial_grid_t& grid)
+{
+  aligned_release (grid.cell_start);
+  aligned_release (grid.cell_cursor);
+  grid.cell_start = nullptr;
+  grid.cell_cursor = nullptr;
+}
+
+
+void initialise_spatial_grid (spatial_grid_t& grid, vector4 screen_dim, sprite_table_t const& sprites, unsigned tile_capacity)
+{
+  grid.screen_dim = screen_dim;
+  grid.tile_capacity = tile_capacity;
+
+  initialise_cells (grid, get_cell_size (sprites));
+
+  grid.tile_cell = (unsigned*)aligned_allocate (tile_capacity * sizeof (unsigned));
+  grid.sorted_tiles = (unsigned*)aligned_allocate (tile_capacity * sizeof (unsigned));
+  grid.half_width = (float*)aligned_allocate (tile_capacity * sizeof (float));
+  grid.half_height = (float*)aligned_allocate (tile_capacity * sizeof (float));
+}
+
+void build_spatial_grid (spatial_grid_t& grid, tiles_t const& tiles, sprite_table_t const& sprites)
+{
+  float const cell_size = get_cell_size (sprites);
+  if (cell_size != grid.cell_size)
+  {
+    release_cells (grid);
+    initialise_cells (grid, cell_size);
+  }
+
+  unsigned const num_cells = grid.cells_x * grid.cells_y;
+  float const inv_cell_size = 1.f / grid.cell_size;
+  auto const pos_x = get_column <tile_pos_x_t> (tiles);
+  auto const pos_y = get_column <tile_pos_y_t> (tiles);
+  auto const object_id = get_column <tile_object_id_t> (tiles);
+
+  // 1. count
+  // cell_start [c + 1] holds the count for cell c, so the prefix sum below leaves cell c's start in cell_start [c]
+  std::fill (grid.cell_start, grid.cell_start + num_cells + 1u, 0u);
+  for (unsigned i = 0; i < tiles.count; i++)
+  {
+    // tiles can poke out past the edge of the play area before the walls push them back, clamp them into the edge cells
+    int const cell_x = std::min (std::max ((int)((pos_x [i] - grid.origin_x) * inv_cell_size), 0), (int)grid.cells_x - 1);
+    int const cell_y = std::min (std::max ((int)((pos_y [i] - grid.origin_y) * inv_cell_size), 0), (int)grid.cells_y - 1);
+    unsigned const cell = (unsigned)cell_y * grid.cells_x + (unsigned)cell_x;
+
+    grid.tile_cell [i] = cell;
+    grid.cell_start [cell + 1u]++;
+
+    sprite_metrics_t const& size = get_sprite_metrics (sprites, object_id [i]);
+    grid.half_width [i] = size.half_width;
+    grid.half_height [i] = size.half_height;
+  }
+
+  // 2. prefix sum
+  for (unsigned cell = 0; cell < num_cells; cell++)
+  {
+    grid.cell_start [cell + 1u] += grid.cell_start [cell];
+    grid.cell_cursor [cell] = grid.cell_start [cell];
+  }
+
+  // 3. scatter
+  for (unsigned i = 0; i < tiles.count; i++)
+  {
+    grid.sorted_tiles [grid.cell_cursor [grid.tile_cell [i]]++] = i;
+  }
+}
+
+void release_spatial_grid (spatial_grid_t& grid)
+{
+  release_cells (grid);
+
+  aligned_release (grid.tile_cell);
+  aligned_release (grid.sorted_tiles);
+  aligned_release (grid.half_width);
+  aligned_release (grid.half_height);
+
+  grid = {};
+}
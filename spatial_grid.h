@@ -0,0 +1,60 @@
+#pragma once
+
+#include "sprites.h" // for sprite_table_t
+#include "utility.h" // for vector4
+
+
+struct tiles_t; // forward declare
+
+
+// SPATIAL GRID
+//
+// Uniform grid broadphase for tile v tile collisions.
+// The play area is split into square cells at least as big as the biggest tile,
+// so a tile can only overlap tiles whose centres are in its own cell or the 8 cells around it.
+// Rebuilt from scratch every frame with a counting sort:
+// 1. count the tiles in each cell
+// 2. prefix sum the counts into each cell's start offset
+// 3. scatter the tile indices so each cell's tiles sit next to each other in { sorted_tiles }
+// This is O(n) in the number of tiles, no matter how they are spread out.
+
+
+struct spatial_grid_t
+{
+  float cell_size;
+  float origin_x; // bottom left corner of the grid
+  float origin_y;
+  unsigned cells_x;
+  unsigned cells_y;
+
+  // cells_x * cells_y + 1 entries
+  // tiles in cell c are sorted_tiles [cell_start [c]] to sorted_tiles [cell_start [c + 1] - 1]
+  unsigned* cell_start;
+  unsigned* cell_cursor; // scratch for the scatter pass
+
+  // one entry per tile
+  unsigned* tile_cell;
+  unsigned* sorted_tiles;
+  float* half_width;  // half the size of each tile, tiles come in different sizes
+  float* half_height;
+
+  vector4 screen_dim;
+  unsigned tile_capacity;
+};
+
+
+/// <summary>
+/// pre game loop grid set up code
+/// </summary>
+void initialise_spatial_grid (spatial_grid_t& grid, vector4 screen_dim, sprite_table_t const& sprites, unsigned tile_capacity);
+
+/// <summary>
+/// bin every tile into its cell, call once per frame before querying the grid
+/// re-creates the cells if the sprite sizes have changed since the last build
+/// </summary>
+void build_spatial_grid (spatial_grid_t& grid, tiles_t const& tiles, sprite_table_t const& sprites);
+
+/// <summary>
+/// post game loop grid tear down code
+/// </summary>
+void release_spatial_grid (spatial_grid_t& grid);
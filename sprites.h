@@ -0,0 +1,106 @@
+#pragma once
+
+#include "constants.h" // for object_id_t
+
+#include <cstdint>     // for std::uint8_t
+
+
+// SPRITES
+//
+// This app uses the size of each object's sub-sprite on the spritesheet as the size of that object in the game world.
+// The simulation never touches the spritesheet itself, it only needs these sizes.
+// They are looked up once, when the spritesheet is loaded, into a sprite_table_t indexed by sprite_id_t,
+// so nothing has to search the spritesheet by name while the game is running.
+// The graphical front end fills the table in from sprites.xml (see get_sprite_table in render.h),
+// headless runs use the defaults below.
+
+
+/// <summary>
+/// every sub-sprite on the spritesheet
+/// </summary>
+enum sprite_id_t : std::uint8_t
+{
+  SPRITE_ID_PLAYER_NORMAL,
+  SPRITE_ID_PLAYER_WIDE,
+  SPRITE_ID_TILE_NORMAL,
+  SPRITE_ID_TILE_WIDE,
+  SPRITE_ID_WALL,
+
+  NUM_SPRITE_IDS,
+};
+
+// name of each sub-sprite in sprites.xml, indexed by sprite_id_t
+char const* const SPRITE_NAMES [NUM_SPRITE_IDS] =
+{
+  "player_0.png",
+  "player_1.png",
+  "tile_0.png",
+  "tile_1.png",
+  "wall.png",
+};
+
+// which sub-sprite each object is drawn with, indexed by object_id_t
+sprite_id_t const OBJECT_SPRITE_IDS [NUM_OBJECT_IDS] =
+{
+  SPRITE_ID_PLAYER_NORMAL, // PLAYER_ID_NORMAL
+  SPRITE_ID_PLAYER_WIDE,   // PLAYER_ID_WIDE
+  SPRITE_ID_TILE_NORMAL,   // TILE_ID_NORMAL
+  SPRITE_ID_TILE_WIDE,     // TILE_ID_WIDE
+  SPRITE_ID_WALL,          // WALL_ID_LEFT
+  SPRITE_ID_WALL,          // WALL_ID_RIGHT
+  SPRITE_ID_WALL,          // WALL_ID_TOP
+  SPRITE_ID_WALL,          // WALL_ID_BOTTOM
+};
+
+
+/// <summary>
+/// size of one sub-sprite
+/// 16 bytes, so SIMD code can load all of it at once
+/// </summary>
+struct alignas (16) sprite_metrics_t
+{
+  float width;
+  float height;
+  float half_width;
+  float half_height;
+};
+
+
+struct sprite_table_t
+{
+  sprite_metrics_t metrics [NUM_SPRITE_IDS];
+};
+
+
+constexpr sprite_metrics_t make_sprite_metrics (float width, float height)
+{
+  return { width, height, width / 2.f, height / 2.f };
+}
+
+/// <summary>
+/// sizes used when there is no spritesheet to read them from, i.e. headless runs
+/// </summary>
+constexpr sprite_table_t SPRITE_TABLE_DEFAULT =
+{
+  {
+    make_sprite_metrics (64.f, 64.f), // player_0.png
+    make_sprite_metrics (96.f, 96.f), // player_1.png
+    make_sprite_metrics (16.f, 16.f), // tile_0.png
+    make_sprite_metrics (24.f, 24.f), // tile_1.png
+    make_sprite_metrics (16.f, 16.f), // wall.png, walls are drawn at their own size, see render_walls
+  }
+};
+
+
+inline sprite_metrics_t const& get_sprite_metrics (sprite_table_t const& sprites, sprite_id_t id)
+{
+  return sprites.metrics [id];
+}
+
+/// <summary>
+/// size of an object in the game world, i.e. the size of the sub-sprite it is drawn with
+/// </summary>
+inline sprite_metrics_t const& get_sprite_metrics (sprite_table_t const& sprites, object_id_t id)
+{
+  return sprites.metrics [OBJECT_SPRITE_IDS [id]];
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "utility.h" // for wait_for_change
+
+#include <atomic>    // for std::atomic
+
+
+// SPSC RING
+//
+// Hands slots from one thread (the producer) to one other thread (the consumer), in order, without locks.
+// The slots live in the ring and are filled and read in place, so nothing is copied in or out:
+// 1. producer: begin_write gives it the next free slot, it fills it in, end_write passes it on
+// 2. consumer: begin_read gives it the oldest full slot, it reads it, end_read gives it back
+// Each side only ever writes its own counter, so a release store on one side and an acquire load on the other
+// is all the synchronisation there is. A side with nothing to do waits with wait_for_change.
+
+
+template <typename T, unsigned N>
+struct spsc_ring_t
+{
+  static_assert (N > 0u && (N & (N - 1u)) == 0u, "the ring must be a power of 2 long, so the counters can wrap");
+
+  T slots [N];
+
+  // how many slots have ever been written and read, on separate cache lines so the 2 threads don't fight over them
+  alignas (64) std::atomic <unsigned> written { 0u };
+  alignas (64) std::atomic <unsigned> read { 0u };
+};
+
+
+/// <summary>
+/// producer: the next slot to fill in, waits while every slot is still waiting to be read
+/// </summary>
+template <typename T, unsigned N>
+T& begin_write (spsc_ring_t <T, N>& ring)
+{
+  unsigned const written = ring.written.load (std::memory_order_relaxed);
+  unsigned read = ring.read.load (std::memory_order_acquire);
+  while (written - read == N)
+  {
+    read = wait_for_change (ring.read, read);
+  }
+
+  return ring.slots [written % N];
+}
+
+/// <summary>
+/// producer: the slot from begin_write is ready to be read
+/// </summary>
+template <typename T, unsigned N>
+void end_write (spsc_ring_t <T, N>& ring)
+{
+  ring.written.store (ring.written.load (std::memory_order_relaxed) + 1u, std::memory_order_release);
+  ring.written.notify_one ();
+}
+
+/// <summary>
+/// consumer: the oldest slot that has been written, waits while there isn't one
+/// </summary>
+template <typename T, unsigned N>
+T& begin_read (spsc_ring_t <T, N>& ring)
+{
+  unsigned const read = ring.read.load (std::memory_order_relaxed);
+  unsigned written = ring.written.load (std::memory_order_acquire);
+  while (written == read)
+  {
+    written = wait_for_change (ring.written, written);
+  }
+
+  return ring.slots [read % N];
+}
+
+/// <summary>
+/// consumer: done with the slot from begin_read, it can be written again
+/// </summary>
+template <typename T, unsigned N>
+void end_read (spsc_ring_t <T, N>& ring)
+{
+  ring.read.store (ring.read.load (std::memory_order_relaxed) + 1u, std::memory_order_release);
+  ring.read.notify_one ();
+}
@@ -0,0 +1,149 @@
+#include "sweep_and_prune.h"
+
+#include "collision.h" // for COLLISION_OVERLAP
+#include "tiles.h"     // for tiles_t
+#include "utility.h"   // for aligned_allocate, aligned_release
+
+#include <algorithm>   // for std::sort
+
+
+static bool operator < (sap_endpoint_t const& lhs, sap_endpoint_t const& rhs)
+{
+  return lhs.value < rhs.value;
+}
+
+
+/// <summary>
+/// sort the endpoints, assuming they are already nearly in order
+/// each endpoint is only moved as far as it needs to go, which is not far if the bodies barely moved
+/// </summary>
+static void insertion_sort (sap_endpoint_t* endpoints, unsigned count)
+{
+  for (unsigned i = 1; i < count; i++)
+  {
+    sap_endpoint_t const endpoint = endpoints [i];
+
+    unsigned j = i;
+    while (j > 0 && endpoint < endpoints [j - 1])
+    {
+      endpoints [j] = endpoints [j - 1];
+      j--;
+    }
+    endpoints [j] = endpoint;
+  }
+}
+
+
+void initialise_sweep_and_prune (sweep_and_prune_t& sap, unsigned num_tiles)
+{
+  sap.num_bodies = num_tiles;
+
+  sap.endpoints = (sap_endpoint_t*)aligned_allocate (sap.num_bodies * 2u * sizeof (sap_endpoint_t));
+  for (unsigned body = 0; body < sap.num_bodies; body++)
+  {
+    sap.endpoints [body * 2u + 0u] = { 0.f, (body << 1) | 0u };
+    sap.endpoints [body * 2u + 1u] = { 0.f, (body << 1) | 1u };
+  }
+  sap.is_sorted = false;
+
+  sap.min_x = (float*)aligned_allocate (sap.num_bodies * sizeof (float));
+  sap.max_x = (float*)aligned_allocate (sap.num_bodies * sizeof (float));
+  sap.min_y = (float*)aligned_allocate (sap.num_bodies * sizeof (float));
+  sap.max_y = (float*)aligned_allocate (sap.num_bodies * sizeof (float));
+  sap.half_width = (float*)aligned_allocate (sap.num_bodies * sizeof (float));
+  sap.half_height = (float*)aligned_allocate (sap.num_bodies * sizeof (float));
+
+  sap.open_bodies = (unsigned*)aligned_allocate (sap.num_bodies * sizeof (unsigned));
+  sap.open_slot = (unsigned*)aligned_allocate (sap.num_bodies * sizeof (unsigned));
+  sap.num_open = 0;
+}
+
+void update_sweep_and_prune (sweep_and_prune_t& sap, tiles_t const& tiles, sprite_table_t const& sprites)
+{
+  float const overlap = COLLISION_OVERLAP / 2.f; // each side gives up half of the allowance
+
+  auto const pos_x = get_column <tile_pos_x_t> (tiles);
+  auto const pos_y = get_column <tile_pos_y_t> (tiles);
+  auto const object_id = get_column <tile_object_id_t> (tiles);
+
+  // 1. refresh each body's AABB
+  for (unsigned i = 0; i < tiles.count; i++)
+  {
+    sprite_metrics_t const& size = get_sprite_metrics (sprites, object_id [i]);
+    sap.half_width [i] = size.half_width;
+    sap.half_height [i] = size.half_height;
+
+    sap.min_x [i] = pos_x [i] - (sap.half_width [i] - overlap);
+    sap.max_x [i] = pos_x [i] + (sap.half_width [i] - overlap);
+    sap.min_y [i] = pos_y [i] - (sap.half_height [i] - overlap);
+    sap.max_y [i] = pos_y [i] + (sap.half_height [i] - overlap);
+  }
+
+  // 2. refresh endpoints and put them back in order
+  unsigned const num_endpoints = sap.num_bodies * 2u;
+  for (unsigned i = 0; i < num_endpoints; i++)
+  {
+    sap_endpoint_t& endpoint = sap.endpoints [i];
+    unsigned const body = endpoint.id >> 1;
+    endpoint.value = (endpoint.id & 1u) ? sap.max_x [body] : sap.min_x [body];
+  }
+
+  if (sap.is_sorted)
+  {
+    insertion_sort (sap.endpoints, num_endpoints);
+  }
+  else
+  {
+    // the first frame has no coherence to exploit, tiles start in random places
+    std::sort (sap.endpoints, sap.endpoints + num_endpoints);
+    sap.is_sorted = true;
+  }
+
+  // 3. sweep
+  sap.tile_pairs.clear ();
+  sap.num_open = 0;
+
+  for (unsigned i = 0; i < num_endpoints; i++)
+  {
+    unsigned const body = sap.endpoints [i].id >> 1;
+    bool const is_max = sap.endpoints [i].id & 1u;
+
+    if (is_max)
+    {
+      // close: swap remove from the open list
+      unsigned const slot = sap.open_slot [body];
+      unsigned const last = sap.open_bodies [--sap.num_open];
+      sap.open_bodies [slot] = last;
+      sap.open_slot [last] = slot;
+      continue;
+    }
+
+    // open: overlaps every open body on x, check y
+    for (unsigned j = 0; j < sap.num_open; j++)
+    {
+      unsigned const other = sap.open_bodies [j];
+      if (sap.min_y [body] < sap.max_y [other] && sap.max_y [body] > sap.min_y [other])
+      {
+        sap.tile_pairs.push_back ({ other, body });
+      }
+    }
+
+    sap.open_slot [body] = sap.num_open;
+    sap.open_bodies [sap.num_open++] = body;
+  }
+}
+
+void release_sweep_and_prune (sweep_and_prune_t& sap)
+{
+  aligned_release (sap.endpoints);
+  aligned_release (sap.min_x);
+  aligned_release (sap.max_x);
+  aligned_release (sap.min_y);
+  aligned_release (sap.max_y);
+  aligned_release (sap.half_width);
+  aligned_release (sap.half_height);
+  aligned_release (sap.open_bodies);
+  aligned_release (sap.open_slot);
+
+  sap = {};
+}
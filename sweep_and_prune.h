@@ -0,0 +1,83 @@
+#pragma once
+
+#include "sprites.h" // for sprite_table_t
+
+#include <vector>    // for std::vector
+
+
+struct tiles_t; // forward declare
+
+
+// SWEEP AND PRUNE
+//
+// Broadphase for tile v tile collisions, the alternative to the spatial grid.
+// Every tile (a body) has a min and max 'endpoint' on the x-axis.
+// All endpoints are kept in one list, sorted by x, which is kept between frames.
+// Tiles move at a constant, slow speed, so each frame the list is nearly sorted already
+// and an insertion sort puts it back in order in close to O(n).
+// Sweeping the sorted list left to right, a body's min endpoint means it starts overlapping (on x)
+// every body that is currently 'open', its max endpoint means it stops.
+// Only those pairs have their y extents tested.
+//
+// The player isn't a body: eat_tiles already tests every tile against it in one SIMD pass,
+// after tile v tile has moved them, which a list of pairs from before that could miss.
+
+
+struct sap_endpoint_t
+{
+  float value; // x position of this end of the body's AABB
+  unsigned id; // (body index << 1) | is_max
+};
+
+
+struct sap_pair_t
+{
+  unsigned lhs;
+  unsigned rhs;
+};
+
+
+struct sweep_and_prune_t
+{
+  unsigned num_bodies;   // one per tile
+
+  // 2 endpoints per body
+  // sorted by value after update_sweep_and_prune
+  sap_endpoint_t* endpoints;
+  bool is_sorted; // false until the first (full) sort
+
+  // AABB of each body, shrunk by the same overlap allowance as the collision code
+  float* min_x;
+  float* max_x;
+  float* min_y;
+  float* max_y;
+
+  // half size of each tile, tiles come in different sizes
+  float* half_width;
+  float* half_height;
+
+  // bodies the sweep is currently inside of
+  unsigned* open_bodies;
+  unsigned* open_slot; // where each body is in { open_bodies }
+  unsigned num_open;
+
+  // results of the last update
+  std::vector <sap_pair_t> tile_pairs; // overlapping tile v tile pairs
+};
+
+
+/// <summary>
+/// pre game loop sweep and prune set up code
+/// </summary>
+void initialise_sweep_and_prune (sweep_and_prune_t& sap, unsigned num_tiles);
+
+/// <summary>
+/// refresh every body's endpoints, re-sort them and sweep for overlapping pairs
+/// call once per frame, results are left in sap.tile_pairs
+/// </summary>
+void update_sweep_and_prune (sweep_and_prune_t& sap, tiles_t const& tiles, sprite_table_t const& sprites);
+
+/// <summary>
+/// post game loop sweep and prune tear down code
+/// </summary>
+void release_sweep_and_prune (sweep_and_prune_t& sap);
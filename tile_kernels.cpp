@@ -0,0 +1,201 @@
+#include "tile_kernels.h"
+
+#include "frame_arena.h" // for frame_allocate_array
+#include "job_system.h"  // for parallel_for, parallel_gather
+#include "tiles.h"       // for tiles_t
+
+#include <cstdlib>    // for std::getenv
+#include <cstring>    // for std::strcmp
+
+#if defined (_MSC_VER)
+#include <intrin.h>   // for __cpuidex, _xgetbv
+#elif defined (__x86_64__)
+#include <cpuid.h>    // for __get_cpuid_count
+#endif
+
+
+#if defined (__x86_64__) || defined (_M_X64)
+
+static void cpuid (unsigned leaf, unsigned subleaf, unsigned registers [4])
+{
+#if defined (_MSC_VER)
+  __cpuidex ((int*)registers, (int)leaf, (int)subleaf);
+#else
+  if (!__get_cpuid_count (leaf, subleaf, &registers [0], &registers [1], &registers [2], &registers [3]))
+  {
+    registers [0] = registers [1] = registers [2] = registers [3] = 0u;
+  }
+#endif
+}
+
+/// <summary>
+/// which register states the OS saves on a context switch (XCR0)
+/// if it doesn't save the wide registers, we can't use them even if the CPU has them
+/// </summary>
+static unsigned long long get_os_saved_state ()
+{
+#if defined (_MSC_VER)
+  return _xgetbv (0);
+#else
+  unsigned eax, edx;
+  __asm__ ("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+  return ((unsigned long long)edx << 32) | eax;
+#endif
+}
+
+#endif
+
+
+kernel_isa_t get_best_kernel_isa ()
+{
+#if defined (__x86_64__) || defined (_M_X64)
+  unsigned leaf_1 [4];
+  cpuid (1u, 0u, leaf_1);
+  bool const has_osxsave = (leaf_1 [2] & (1u << 27)) != 0u;
+  // checked as well as the leaf 7 bits, a hypervisor can hide AVX and still report AVX2 or AVX-512
+  bool const has_avx = (leaf_1 [2] & (1u << 28)) != 0u;
+  if (!has_osxsave || !has_avx)
+  {
+    return kernel_isa_t::SSE2;
+  }
+
+  unsigned long long const os_saved_state = get_os_saved_state ();
+  bool const os_saves_ymm = (os_saved_state & 0x06u) == 0x06u; // SSE + AVX state
+  bool const os_saves_zmm = (os_saved_state & 0xe6u) == 0xe6u; // + opmask, ZMM0-15 upper halves, ZMM16-31
+
+  unsigned leaf_7 [4];
+  cpuid (7u, 0u, leaf_7);
+  bool const has_avx2 = (leaf_7 [1] & (1u << 5)) != 0u;
+  bool const has_avx512f = (leaf_7 [1] & (1u << 16)) != 0u;
+
+  if (has_avx512f && os_saves_zmm)
+  {
+    return kernel_isa_t::AVX512;
+  }
+  if (has_avx2 && os_saves_ymm)
+  {
+    return kernel_isa_t::AVX2;
+  }
+  return kernel_isa_t::SSE2;
+#else
+  return kernel_isa_t::SCALAR;
+#endif
+}
+
+
+static tile_kernels_t const* get_tile_kernels_for (kernel_isa_t isa)
+{
+  switch (isa)
+  {
+#if defined (__x86_64__) || defined (_M_X64)
+    case kernel_isa_t::SSE2:   return &TILE_KERNELS_SSE2;
+    case kernel_isa_t::AVX2:   return &TILE_KERNELS_AVX2;
+    case kernel_isa_t::AVX512: return &TILE_KERNELS_AVX512;
+#endif
+    case kernel_isa_t::SCALAR: return &TILE_KERNELS_SCALAR;
+    default:                   return nullptr;
+  }
+}
+
+
+static tile_kernels_t const* current_tile_kernels = nullptr;
+
+tile_kernels_t const& get_tile_kernels ()
+{
+  if (current_tile_kernels == nullptr)
+  {
+    current_tile_kernels = get_tile_kernels_for (get_best_kernel_isa ());
+
+    kernel_isa_t isa;
+    char const* const forced = std::getenv ("SHOT1_TILE_KERNELS");
+    if (forced != nullptr && parse_kernel_isa (forced, isa))
+    {
+      select_tile_kernels (isa);
+    }
+  }
+
+  return *current_tile_kernels;
+}
+
+bool select_tile_kernels (kernel_isa_t isa)
+{
+  // kernel_isa_t is ordered narrowest first
+  tile_kernels_t const* kernels = get_tile_kernels_for (isa);
+  if (kernels == nullptr || isa > get_best_kernel_isa ())
+  {
+    return false;
+  }
+
+  current_tile_kernels = kernels;
+  return true;
+}
+
+bool parse_kernel_isa (char const* name, kernel_isa_t& isa)
+{
+  if (std::strcmp (name, "scalar") == 0)      { isa = kernel_isa_t::SCALAR; }
+  else if (std::strcmp (name, "sse2") == 0)   { isa = kernel_isa_t::SSE2; }
+  else if (std::strcmp (name, "avx2") == 0)   { isa = kernel_isa_t::AVX2; }
+  else if (std::strcmp (name, "avx512") == 0) { isa = kernel_isa_t::AVX512; }
+  else
+  {
+    return false;
+  }
+
+  return true;
+}
+
+
+// KERNELS
+
+void update_tiles (tiles_t& tiles, float speed, float angle_speed, float elapsed, job_system_t& jobs)
+{
+  auto const update = get_tile_kernels ().update;
+  parallel_for (jobs, tiles.count, TILES_PER_JOB, [&] (unsigned begin, unsigned end)
+  {
+    update (tiles, begin, end, speed, angle_speed, elapsed);
+  });
+  tiles.angle_step = angle_speed;
+}
+
+// each chunk marks eaten and expired tiles in whole words of tiles.respawn_bits that no other chunk touches
+static_assert (TILES_PER_JOB % TILES_PER_RESPAWN_WORD == 0, "chunks must start on a respawn_bits word");
+
+unsigned eat_tiles (tiles_t& tiles, eat_query_t const& query, frame_arena_t& arena, job_system_t& jobs)
+{
+  auto const eat = get_tile_kernels ().eat;
+  // room for every tile, the chunks' lists are packed together from the front
+  tiles.eaten_indices = frame_allocate_array <unsigned> (arena, tiles.count);
+  tiles.num_eaten = parallel_gather (jobs, tiles.count, TILES_PER_JOB, tiles.eaten_indices,
+    [&] (unsigned begin, unsigned end, unsigned* eaten)
+    {
+      return eat (tiles, begin, end, query, eaten);
+    });
+  return tiles.num_eaten;
+}
+
+void bounce_tiles (tiles_t& tiles, arena_query_t const& query, job_system_t& jobs)
+{
+  auto const bounce = get_tile_kernels ().bounce;
+  parallel_for (jobs, tiles.count, TILES_PER_JOB, [&] (unsigned begin, unsigned end)
+  {
+    bounce (tiles, begin, end, query);
+  });
+}
+
+void transform_tiles (tiles_t const& tiles, transform_query_t const& query, tile_transforms_t& transforms, job_system_t& jobs)
+{
+  auto const transform = get_tile_kernels ().transform;
+  parallel_for (jobs, tiles.count, TILES_PER_JOB, [&] (unsigned begin, unsigned end)
+  {
+    transform (tiles, begin, end, query, transforms);
+  });
+}
+
+void fill_random (random_query_t const& query, std::uint32_t const* counters, unsigned count, random_blocks_t& blocks, job_system_t& jobs)
+{
+  auto const random = get_tile_kernels ().random;
+  parallel_for (jobs, count, TILES_PER_JOB, [&] (unsigned begin, unsigned end)
+  {
+    random (query, counters, begin, end, blocks);
+  });
+}
@@ -0,0 +1,199 @@
+#pragma once
+
+#include "utility.h" // for CACHE_LINE_SIZE
+
+#include <cstdint>   // for std::uint32_t
+
+
+struct tiles_t; // forward declare
+struct tile_transforms_t;
+struct job_system_t;
+struct frame_arena_t;
+struct random_query_t;
+struct random_blocks_t;
+
+
+// TILE KERNELS
+//
+// SIMD loops over the tiles_t arrays.
+// Written once in tile_kernels.inl against the simd_*_t wrappers,
+// then built once per instruction set (tile_kernels_scalar.cpp, tile_kernels_sse2.cpp...),
+// each build compiled with the flags for its instruction set.
+// At startup the widest set the CPU supports is picked, see get_tile_kernels.
+//
+// SIMD kernels run over whole vectors, the arrays are padded to { tiles.capacity } so they never read past the end.
+// Lanes past { tiles.count } are masked off wherever their result would be seen.
+// The scalar kernels stop at exactly { tiles.count } and are the reference the others are checked against.
+//
+// Each kernel runs over a range of tiles, [begin, end).
+// update_tiles etc. split the tiles into ranges of { TILES_PER_JOB } and spread them over the job system's threads.
+// Ranges start on a cache line, so no 2 threads write to the same line, and every vector load stays aligned.
+// The only kernel with a result is eat_tiles, each range lists what it ate and the lists are joined in order,
+// so the result is the same however many threads there are.
+
+
+/// <summary>
+/// tiles per parallel_for chunk, a whole number of cache lines
+/// enough work per chunk that taking it costs next to nothing, small enough for a few chunks per thread at 100k+ tiles
+/// </summary>
+unsigned const TILES_PER_JOB = 4096u;
+static_assert (TILES_PER_JOB % (CACHE_LINE_SIZE / sizeof (float)) == 0, "chunks must start on a cache line");
+
+
+/// <summary>
+/// the player's AABB, and how close each type of tile has to get to it to be eaten
+/// </summary>
+struct eat_query_t
+{
+  float player_x;
+  float player_y;
+
+  // largest distance between the player's and a tile's centre, on each axis, for them to overlap
+  // i.e. half the player's size + half the tile's size - { COLLISION_OVERLAP }
+  float reach_x_normal;
+  float reach_y_normal;
+  float reach_x_wide;
+  float reach_y_wide;
+};
+
+
+/// <summary>
+/// the inside faces of the 4 walls, and how big each type of tile is
+/// </summary>
+struct arena_query_t
+{
+  // the walls are far thicker and longer than the screen, so only their inside faces matter
+  float left;
+  float right;
+  float bottom;
+  float top;
+
+  float half_width_normal;
+  float half_height_normal;
+  float half_width_wide;
+  float half_height_wide;
+
+  // a tile may poke this far into a wall before it bounces, { COLLISION_OVERLAP }
+  float overlap;
+};
+
+
+/// <summary>
+/// the size each type of tile is drawn at, and when between the last 2 steps to draw it
+/// </summary>
+struct transform_query_t
+{
+  float width_normal;
+  float height_normal;
+  float width_wide;
+  float height_wide;
+
+  // how much of the way back to its position and angle before the last step to draw each tile
+  // 0 = where it is now, 1 = where it was a step ago
+  float prev_weight;
+  float angle_step; // tiles_t::angle_step
+};
+
+
+/// <summary>
+/// instruction sets the kernels are built for, narrowest first
+/// </summary>
+enum class kernel_isa_t
+{
+  SCALAR,
+  SSE2,
+  AVX2,
+  AVX512,
+};
+
+
+/// <summary>
+/// one build of every kernel
+/// </summary>
+struct tile_kernels_t
+{
+  char const* name;
+  kernel_isa_t isa;
+
+  void (*update) (tiles_t& tiles, unsigned begin, unsigned end, float speed, float angle_speed, float elapsed);
+  unsigned (*eat) (tiles_t& tiles, unsigned begin, unsigned end, eat_query_t const& query, unsigned* eaten);
+  void (*bounce) (tiles_t& tiles, unsigned begin, unsigned end, arena_query_t const& query);
+  void (*transform) (tiles_t const& tiles, unsigned begin, unsigned end, transform_query_t const& query, tile_transforms_t& transforms);
+  // the sin and cos the transforms use, of each of { angles }, every array aligned to a cache line and { count } a multiple of 16
+  void (*sincos) (float const* angles, unsigned count, float* sin_angles, float* cos_angles);
+  void (*random) (random_query_t const& query, std::uint32_t const* counters, unsigned begin, unsigned end, random_blocks_t& blocks);
+};
+
+
+extern tile_kernels_t const TILE_KERNELS_SCALAR;
+#if defined (__x86_64__) || defined (_M_X64)
+extern tile_kernels_t const TILE_KERNELS_SSE2;
+extern tile_kernels_t const TILE_KERNELS_AVX2;
+extern tile_kernels_t const TILE_KERNELS_AVX512;
+#endif
+
+
+/// <summary>
+/// the widest instruction set both this CPU and the OS support
+/// </summary>
+kernel_isa_t get_best_kernel_isa ();
+
+/// <summary>
+/// the kernels currently in use
+/// on first use this is the build for get_best_kernel_isa,
+/// unless the SHOT1_TILE_KERNELS environment variable names another one (scalar, sse2, avx2 or avx512)
+/// </summary>
+tile_kernels_t const& get_tile_kernels ();
+
+/// <summary>
+/// force a particular build of the kernels, e.g. to A/B test them
+/// call before the simulation starts, not while it is stepping
+/// </summary>
+/// <returns>false if this CPU can't run that instruction set, the current kernels are kept</returns>
+bool select_tile_kernels (kernel_isa_t isa);
+
+/// <summary>
+/// "scalar", "sse2", "avx2" or "avx512" to a kernel_isa_t
+/// </summary>
+/// <returns>false if the name isn't recognised</returns>
+bool parse_kernel_isa (char const* name, kernel_isa_t& isa);
+
+
+/// <summary>
+/// TILES
+/// move and rotate every tile by one frame, and count down their lifetimes
+/// tiles whose lifetime runs out are marked in tiles.respawn_bits
+/// </summary>
+/// <param name="speed">distance moved this frame, { TILE_SPEED_MOVEMENT } * elapsed</param>
+/// <param name="angle_speed">radians turned this frame, { TILE_SPEED_ROTATION } * elapsed</param>
+/// <param name="elapsed">frame time, in seconds</param>
+void update_tiles (tiles_t& tiles, float speed, float angle_speed, float elapsed, job_system_t& jobs);
+
+/// <summary>
+/// PLAYER v TILE
+/// test every tile against the player's AABB
+/// eaten tiles are marked in tiles.respawn_bits and their indices listed in tiles.eaten_indices, lowest first
+/// the list is allocated from { arena }
+/// </summary>
+/// <returns>the number of tiles eaten</returns>
+unsigned eat_tiles (tiles_t& tiles, eat_query_t const& query, frame_arena_t& arena, job_system_t& jobs);
+
+/// <summary>
+/// TILE v WALL
+/// push every tile that has gone into a wall back out, and reflect its velocity off that wall
+/// </summary>
+void bounce_tiles (tiles_t& tiles, arena_query_t const& query, job_system_t& jobs);
+
+/// <summary>
+/// RENDER PREP
+/// every tile's 2D transform, from its position, angle and size, interpolated back towards the step before
+/// </summary>
+void transform_tiles (tiles_t const& tiles, transform_query_t const& query, tile_transforms_t& transforms, job_system_t& jobs);
+
+/// <summary>
+/// RANDOM
+/// the Philox block for each of { counters } [0, count), see random.h
+/// { counters } and each of blocks.words must be aligned to a cache line,
+/// and have room for { count } rounded up to a whole cache line of uint32s
+/// </summary>
+void fill_random (random_query_t const& query, std::uint32_t const* counters, unsigned count, random_blocks_t& blocks, job_system_t& jobs);
@@ -0,0 +1,444 @@
+// TILE KERNELS
+//
+// Kernel bodies, written against the simd_*_t wrappers.
+// Included by each tile_kernels_<isa>.cpp once the wrapper it is built for has been included.
+// Everything is in an unnamed namespace, each file that includes this gets its own copy
+// compiled with its own instruction set, so the linker can't mix them up.
+
+
+#include "random.h"          // for random_query_t, random_blocks_t, PHILOX_*
+#include "tile_kernels.h"    // for tile_kernels_t, eat_query_t, arena_query_t, transform_query_t
+#include "tile_transforms.h" // for tile_transforms_t
+#include "tiles.h"           // for tiles_t
+
+#include <bit>         // for std::countr_zero
+#include <cstdint>     // for std::uint8_t, std::uint32_t, std::uint64_t
+#include <type_traits> // for std::is_same_v
+
+
+namespace
+{
+
+static_assert (std::is_same_v <tile_real_t, float>, "the tile kernels work on float lanes, see TILE_PRECISION");
+
+
+/// <summary>
+/// mask for the lanes of the vector starting at { index } that are before { end }, i.e. are in range and not padding
+/// </summary>
+template <typename simd>
+unsigned get_tail_bits (unsigned index, unsigned end)
+{
+  unsigned const lanes_left = end - index;
+  return lanes_left >= (unsigned)simd::LANES ? ~0u : (1u << lanes_left) - 1u;
+}
+
+
+// 2 pi and pi / 2, each split into a float that holds it to ~16 bits plus a float for the rest (Cody-Waite),
+// so that subtracting k * 2 pi (or k * pi / 2) loses no more precision than the subtraction itself
+float const TWO_PI_HI = 6.28125f;
+float const TWO_PI_LO = 1.9353071795864769253e-3f;
+float const HALF_PI_1 = 1.5703125f;
+float const HALF_PI_2 = 4.837512969970703125e-4f;
+float const HALF_PI_3 = 7.54978995489188216e-8f;
+
+
+/// <summary>
+/// per lane sin and cos of { angle }, in radians
+/// reduces the angle to [-pi/4, pi/4] around the nearest multiple of pi/2,
+/// evaluates a minimax polynomial for each of sin and cos (Cephes' sinf/cosf coefficients),
+/// then swaps and negates them for the quadrant the angle was in
+/// error: at most 8e-8 from the true value (under 1 ulp of 1.0) for every float in [-pi, pi],
+/// and up to |angle| < 8192, well past anything the wrapped tile angles reach
+/// checked against double precision for every one of those floats by benchmark --check sincos
+/// </summary>
+template <typename simd>
+void sincos (typename simd::vfloat angle, typename simd::vfloat& sin_angle, typename simd::vfloat& cos_angle)
+{
+  using vfloat = typename simd::vfloat;
+  using vmask = typename simd::vmask;
+
+  // quadrant = nearest whole number of pi/2s
+  vfloat const quadrant = simd::floor (simd::add (simd::mul (angle, simd::set1 (0.63661977236758134308f)), simd::set1 (0.5f)));
+
+  // x = angle - quadrant * pi/2, in [-pi/4, pi/4]
+  vfloat x = simd::sub (angle, simd::mul (quadrant, simd::set1 (HALF_PI_1)));
+  x = simd::sub (x, simd::mul (quadrant, simd::set1 (HALF_PI_2)));
+  x = simd::sub (x, simd::mul (quadrant, simd::set1 (HALF_PI_3)));
+  vfloat const x2 = simd::mul (x, x);
+
+  // sin (x) = x + x^3 * (s1 + x^2 * (s2 + x^2 * s3))
+  vfloat sin_x = simd::add (simd::mul (simd::set1 (-1.9515295891e-4f), x2), simd::set1 (8.3321608736e-3f));
+  sin_x = simd::add (simd::mul (sin_x, x2), simd::set1 (-1.6666654611e-1f));
+  sin_x = simd::add (simd::mul (simd::mul (sin_x, x2), x), x);
+
+  // cos (x) = 1 - x^2 / 2 + x^4 * (c1 + x^2 * (c2 + x^2 * c3))
+  vfloat cos_x = simd::add (simd::mul (simd::set1 (2.443315711809948e-5f), x2), simd::set1 (-1.388731625493765e-3f));
+  cos_x = simd::add (simd::mul (cos_x, x2), simd::set1 (4.166664568298827e-2f));
+  cos_x = simd::add (simd::sub (simd::mul (simd::mul (cos_x, x2), x2), simd::mul (x2, simd::set1 (0.5f))), simd::set1 (1.f));
+
+  // quadrant mod 4, then:
+  //   0: sin =  sin_x, cos =  cos_x
+  //   1: sin =  cos_x, cos = -sin_x
+  //   2: sin = -sin_x, cos = -cos_x
+  //   3: sin = -cos_x, cos =  sin_x
+  vfloat const quadrant_mod_4 = simd::sub (quadrant, simd::mul (simd::floor (simd::mul (quadrant, simd::set1 (0.25f))), simd::set1 (4.f)));
+  vmask const is_odd = simd::mask_or (
+    simd::mask_and (simd::cmp_gt (quadrant_mod_4, simd::set1 (0.5f)), simd::cmp_lt (quadrant_mod_4, simd::set1 (1.5f))),
+    simd::cmp_gt (quadrant_mod_4, simd::set1 (2.5f)));
+  vmask const negate_sin = simd::cmp_gt (quadrant_mod_4, simd::set1 (1.5f));
+  vmask const negate_cos = simd::mask_and (simd::cmp_gt (quadrant_mod_4, simd::set1 (0.5f)), simd::cmp_lt (quadrant_mod_4, simd::set1 (2.5f)));
+
+  vfloat const sin_unsigned = simd::select (is_odd, cos_x, sin_x);
+  vfloat const cos_unsigned = simd::select (is_odd, sin_x, cos_x);
+  sin_angle = simd::select (negate_sin, simd::neg (sin_unsigned), sin_unsigned);
+  cos_angle = simd::select (negate_cos, simd::neg (cos_unsigned), cos_unsigned);
+}
+
+
+template <typename simd>
+void update_tiles_kernel (tiles_t& tiles, unsigned begin, unsigned end, float speed, float angle_speed, float elapsed)
+{
+  using vfloat = typename simd::vfloat;
+
+  vfloat const speed_vector = simd::set1 (speed);
+  vfloat const angle_speed_vector = simd::set1 (angle_speed);
+  vfloat const inv_two_pi = simd::set1 (0.15915494309189533577f);
+  vfloat const half = simd::set1 (0.5f);
+  vfloat const two_pi_hi = simd::set1 (TWO_PI_HI);
+  vfloat const two_pi_lo = simd::set1 (TWO_PI_LO);
+  vfloat const elapsed_vector = simd::set1 (elapsed);
+  vfloat const zero = simd::set1 (0.f);
+  static_assert (TILES_PER_RESPAWN_WORD % simd::LANES == 0, "a vector's expiry bits must fit in one respawn word");
+
+  auto const pos_x = get_column <tile_pos_x_t> (tiles);
+  auto const pos_y = get_column <tile_pos_y_t> (tiles);
+  auto const vel_x = get_column <tile_vel_x_t> (tiles);
+  auto const vel_y = get_column <tile_vel_y_t> (tiles);
+  auto const angle = get_column <tile_angle_t> (tiles);
+  auto const lifetime = get_column <tile_lifetime_t> (tiles);
+  auto const prev_pos_x = get_column <tile_prev_pos_x_t> (tiles);
+  auto const prev_pos_y = get_column <tile_prev_pos_y_t> (tiles);
+
+  // the padding lanes of the last vector are updated too, the pool allows it (see soa_pool.h)
+  // nothing ever sets their velocity, so they stay where the pool zeroed them, their angle is never read
+  // and their lifetime counts down for ever, but is masked off so they are never marked to respawn
+  for (unsigned i = begin; i < end; i += simd::LANES)
+  {
+    // keep where the tile was, for the front end to interpolate from
+    vfloat const old_x = simd::load (pos_x + i);
+    vfloat const old_y = simd::load (pos_y + i);
+    simd::store (prev_pos_x + i, old_x);
+    simd::store (prev_pos_y + i, old_y);
+
+    // update position
+    // pos += vel * speed
+    simd::store (pos_x + i, simd::add (old_x, simd::mul (simd::load (vel_x + i), speed_vector)));
+    simd::store (pos_y + i, simd::add (old_y, simd::mul (simd::load (vel_y + i), speed_vector)));
+
+    // update angle
+    // then wrap it back into [-pi, pi) by taking off the nearest whole number of turns,
+    // left to grow, a float angle loses precision and after a few hours the rotation visibly steps
+    vfloat new_angle = simd::add (simd::load (angle + i), angle_speed_vector);
+    vfloat const turns = simd::floor (simd::add (simd::mul (new_angle, inv_two_pi), half));
+    new_angle = simd::sub (new_angle, simd::mul (turns, two_pi_hi));
+    new_angle = simd::sub (new_angle, simd::mul (turns, two_pi_lo));
+    simd::store (angle + i, new_angle);
+
+    // count down the lifetime, tiles that run out are marked to be replaced at the end of the step
+    // { i } is a multiple of LANES, so all of a vector's lanes fall in the same respawn word
+    vfloat const time_left = simd::sub (simd::load (lifetime + i), elapsed_vector);
+    simd::store (lifetime + i, time_left);
+    unsigned const expired_bits = simd::mask_bits (simd::cmp_lt (time_left, zero)) & get_tail_bits <simd> (i, end);
+    if (expired_bits != 0u)
+    {
+      tiles.respawn_bits [i / TILES_PER_RESPAWN_WORD] |= (std::uint64_t)expired_bits << (i % TILES_PER_RESPAWN_WORD);
+    }
+  }
+}
+
+
+template <typename simd>
+unsigned eat_tiles_kernel (tiles_t& tiles, unsigned begin, unsigned end, eat_query_t const& query, unsigned* eaten)
+{
+  using vfloat = typename simd::vfloat;
+  using vmask = typename simd::vmask;
+
+  vfloat const player_x = simd::set1 (query.player_x);
+  vfloat const player_y = simd::set1 (query.player_y);
+  vfloat const reach_x_normal = simd::set1 (query.reach_x_normal);
+  vfloat const reach_y_normal = simd::set1 (query.reach_y_normal);
+  vfloat const reach_x_wide = simd::set1 (query.reach_x_wide);
+  vfloat const reach_y_wide = simd::set1 (query.reach_y_wide);
+
+  auto const pos_x = get_column <tile_pos_x_t> (tiles);
+  auto const pos_y = get_column <tile_pos_y_t> (tiles);
+  auto const object_id = get_column <tile_object_id_t> (tiles);
+
+  unsigned num_eaten = 0;
+  for (unsigned i = begin; i < end; i += simd::LANES)
+  {
+    // per tile size, without branching on the tile's type
+    vmask const is_wide = simd::load_bytes_eq ((std::uint8_t const*)(object_id + i), TILE_ID_WIDE);
+    vfloat const reach_x = simd::select (is_wide, reach_x_wide, reach_x_normal);
+    vfloat const reach_y = simd::select (is_wide, reach_y_wide, reach_y_normal);
+
+    // overlapping = centres are within reach on both axes
+    vfloat const distance_x = simd::abs (simd::sub (simd::load (pos_x + i), player_x));
+    vfloat const distance_y = simd::abs (simd::sub (simd::load (pos_y + i), player_y));
+    vmask const hit = simd::mask_and (simd::cmp_lt (distance_x, reach_x), simd::cmp_lt (distance_y, reach_y));
+
+    // almost always 0, the player is only ever touching a handful of tiles
+    unsigned hit_bits = simd::mask_bits (hit) & get_tail_bits <simd> (i, end);
+    while (hit_bits != 0u)
+    {
+      unsigned const tile = i + (unsigned)std::countr_zero (hit_bits);
+      hit_bits &= hit_bits - 1u;
+
+      mark_tile_for_respawn (tiles, tile);
+      eaten [num_eaten++] = tile;
+    }
+  }
+
+  return num_eaten;
+}
+
+
+template <typename simd>
+void bounce_tiles_kernel (tiles_t& tiles, unsigned begin, unsigned end, arena_query_t const& query)
+{
+  using vfloat = typename simd::vfloat;
+  using vmask = typename simd::vmask;
+
+  vfloat const left = simd::set1 (query.left);
+  vfloat const right = simd::set1 (query.right);
+  vfloat const bottom = simd::set1 (query.bottom);
+  vfloat const top = simd::set1 (query.top);
+  vfloat const half_width_normal = simd::set1 (query.half_width_normal);
+  vfloat const half_height_normal = simd::set1 (query.half_height_normal);
+  vfloat const half_width_wide = simd::set1 (query.half_width_wide);
+  vfloat const half_height_wide = simd::set1 (query.half_height_wide);
+  vfloat const overlap = simd::set1 (query.overlap);
+
+  auto const pos_x = get_column <tile_pos_x_t> (tiles);
+  auto const pos_y = get_column <tile_pos_y_t> (tiles);
+  auto const vel_x = get_column <tile_vel_x_t> (tiles);
+  auto const vel_y = get_column <tile_vel_y_t> (tiles);
+  auto const object_id = get_column <tile_object_id_t> (tiles);
+
+  // the padding lanes sit still at the centre of the screen (see update_tiles_kernel), so never touch a wall
+  for (unsigned i = begin; i < end; i += simd::LANES)
+  {
+    vmask const is_wide = simd::load_bytes_eq ((std::uint8_t const*)(object_id + i), TILE_ID_WIDE);
+    vfloat const half_width = simd::select (is_wide, half_width_wide, half_width_normal);
+    vfloat const half_height = simd::select (is_wide, half_height_wide, half_height_normal);
+
+    // where the tile's centre is when its edge is flush with each wall
+    vfloat const min_x = simd::add (left, half_width);
+    vfloat const max_x = simd::sub (right, half_width);
+    vfloat const min_y = simd::add (bottom, half_height);
+    vfloat const max_y = simd::sub (top, half_height);
+
+    // x axis, left and right walls
+    {
+      vfloat const position = simd::load (pos_x + i);
+      vfloat const velocity = simd::load (vel_x + i);
+      vmask const hit_left = simd::cmp_lt (position, simd::sub (min_x, overlap));
+      vmask const hit_right = simd::cmp_gt (position, simd::add (max_x, overlap));
+
+      // position response: move the tile out so it is touching the wall
+      // velocity response: the walls are aligned with the y axis, so reflect the x velocity
+      simd::store (pos_x + i, simd::select (hit_left, min_x, simd::select (hit_right, max_x, position)));
+      simd::store (vel_x + i, simd::select (simd::mask_or (hit_left, hit_right), simd::neg (velocity), velocity));
+    }
+
+    // y axis, bottom and top walls
+    {
+      vfloat const position = simd::load (pos_y + i);
+      vfloat const velocity = simd::load (vel_y + i);
+      vmask const hit_bottom = simd::cmp_lt (position, simd::sub (min_y, overlap));
+      vmask const hit_top = simd::cmp_gt (position, simd::add (max_y, overlap));
+
+      simd::store (pos_y + i, simd::select (hit_bottom, min_y, simd::select (hit_top, max_y, position)));
+      simd::store (vel_y + i, simd::select (simd::mask_or (hit_bottom, hit_top), simd::neg (velocity), velocity));
+    }
+  }
+
+  // By adjusting the tile's position we have stopped the tile and wall from overlapping.
+  // By reflecting the tile's velocity the tile will not collide with it on the next frame.
+  // Job done!
+
+
+  // N.B.
+  // This collision resolution is not fully physically accurate (but is more than acceptable for our purposes.)
+  // e.g. on tile collision with y-oriented walls (left and right)
+  // we only reflect its x velocity and move it out of the wall.
+  // Why could this cause a bug/be less realistic? (Think of other objects, think velocity repsonse timing...)
+  // 1 frame
+  //                   wall
+  //                    |
+  //            o-o     |
+  //      start | |\    |
+  //            o-o \   |
+  //                 \  |
+  //                 o-o|
+  //      ours final | |x
+  //                 o-o|\
+  //                  / | \
+  //                 /  |  \
+  //            o-o /   |   \ o-o
+  // real final | |/    |    \| | tunnelling final
+  //            o-o     |     o-o this would happen if the walls were too thin!
+  //                    |
+  //
+  // But, why is ours solution (generally) acceptable? (Think temporal...)
+  // What strategies could help improve this? (Think 'sub-steps', think swept volumes, think collision time...)
+  //
+  // This is just a thought experiment, please DO NOT attempt to fix this here!
+  // More physically accurate collision detection and resolution gets complex real quick.
+  // It's just interesting to discuss :)
+  // If you want to learn more about how 'real'/commercial collision systems actually work, ask Andy
+  // or your 'mega-module' lecturer to point you in the right direction and then do some research!
+  // Here is a starter: https://tinyurl.com/mrw4d3k
+  // Your final year project gives you an excellent opportunity to explore these sorts of things in depth.
+}
+
+
+template <typename simd>
+void transform_tiles_kernel (tiles_t const& tiles, unsigned begin, unsigned end, transform_query_t const& query, tile_transforms_t& transforms)
+{
+  using vfloat = typename simd::vfloat;
+  using vmask = typename simd::vmask;
+
+  vfloat const width_normal = simd::set1 (query.width_normal);
+  vfloat const height_normal = simd::set1 (query.height_normal);
+  vfloat const width_wide = simd::set1 (query.width_wide);
+  vfloat const height_wide = simd::set1 (query.height_wide);
+  vfloat const prev_weight = simd::set1 (query.prev_weight);
+  // every tile turned the same way in the last step, and by less than a turn
+  vfloat const angle_back = simd::mul (simd::set1 (-query.angle_step), prev_weight);
+
+  auto const pos_x = get_column <tile_pos_x_t> (tiles);
+  auto const pos_y = get_column <tile_pos_y_t> (tiles);
+  auto const prev_pos_x = get_column <tile_prev_pos_x_t> (tiles);
+  auto const prev_pos_y = get_column <tile_prev_pos_y_t> (tiles);
+  auto const angle = get_column <tile_angle_t> (tiles);
+  auto const object_id = get_column <tile_object_id_t> (tiles);
+
+  for (unsigned i = begin; i < end; i += simd::LANES)
+  {
+    // part way back towards where the tile was before the last step
+    // written as now + (prev - now) * weight, so a weight of 0 gives exactly where the tile is now
+    vfloat const now_x = simd::load (pos_x + i);
+    vfloat const now_y = simd::load (pos_y + i);
+    vfloat const position_x = simd::add (now_x, simd::mul (simd::sub (simd::load (prev_pos_x + i), now_x), prev_weight));
+    vfloat const position_y = simd::add (now_y, simd::mul (simd::sub (simd::load (prev_pos_y + i), now_y), prev_weight));
+
+    // turned back by the same part of the last step, no need to wrap, sincos is accurate well past [-pi, pi)
+    vfloat const drawn_angle = simd::add (simd::load (angle + i), angle_back);
+
+    vfloat s, c;
+    sincos <simd> (drawn_angle, s, c);
+
+    vmask const is_wide = simd::load_bytes_eq ((std::uint8_t const*)(object_id + i), TILE_ID_WIDE);
+    vfloat const width = simd::select (is_wide, width_wide, width_normal);
+    vfloat const height = simd::select (is_wide, height_wide, height_normal);
+
+    // rotation * scale, see tile_transforms.h
+    simd::store (transforms.x_axis_x + i, simd::mul (c, width));
+    simd::store (transforms.x_axis_y + i, simd::mul (s, width));
+    simd::store (transforms.y_axis_x + i, simd::mul (simd::neg (s), height));
+    simd::store (transforms.y_axis_y + i, simd::mul (c, height));
+
+    // then position
+    simd::store (transforms.position_x + i, position_x);
+    simd::store (transforms.position_y + i, position_y);
+  }
+}
+
+
+/// <summary>
+/// sincos of each of { angles }, only used to check its error (see benchmark --check sincos)
+/// </summary>
+template <typename simd>
+void sincos_kernel (float const* angles, unsigned count, float* sin_angles, float* cos_angles)
+{
+  using vfloat = typename simd::vfloat;
+
+  for (unsigned i = 0; i < count; i += simd::LANES)
+  {
+    vfloat s, c;
+    sincos <simd> (simd::load (angles + i), s, c);
+    simd::store (sin_angles + i, s);
+    simd::store (cos_angles + i, c);
+  }
+}
+
+
+/// <summary>
+/// one Philox4x32-10 block per counter, a vector of counters at a time
+/// each lane runs the rounds on its own counter, exactly as the paper's one block at a time version does
+/// </summary>
+template <typename simd>
+void random_kernel (random_query_t const& query, std::uint32_t const* counters, unsigned begin, unsigned end, random_blocks_t& blocks)
+{
+  using vuint = typename simd::vuint;
+
+  vuint const m0 = simd::set1_u (PHILOX_M0);
+  vuint const m1 = simd::set1_u (PHILOX_M1);
+  vuint const w0 = simd::set1_u (PHILOX_W0);
+  vuint const w1 = simd::set1_u (PHILOX_W1);
+
+  // the lanes past { end } work on whatever is in the padding, their blocks are never read
+  for (unsigned i = begin; i < end; i += simd::LANES)
+  {
+    vuint c0 = simd::load_u (counters + i);
+    vuint c1 = simd::set1_u (query.counter_1);
+    vuint c2 = simd::set1_u (query.counter_2);
+    vuint c3 = simd::set1_u (query.counter_3);
+    vuint k0 = simd::set1_u (query.key.words [0]);
+    vuint k1 = simd::set1_u (query.key.words [1]);
+
+    for (unsigned round = 0; round < PHILOX_ROUNDS; round++)
+    {
+      vuint hi0, lo0, hi1, lo1;
+      simd::mul_wide_u (m0, c0, hi0, lo0);
+      simd::mul_wide_u (m1, c2, hi1, lo1);
+
+      c0 = simd::xor_u (simd::xor_u (hi1, c1), k0);
+      c1 = lo1;
+      c2 = simd::xor_u (simd::xor_u (hi0, c3), k1);
+      c3 = lo0;
+
+      k0 = simd::add_u (k0, w0);
+      k1 = simd::add_u (k1, w1);
+    }
+
+    simd::store_u (blocks.words [0] + i, c0);
+    simd::store_u (blocks.words [1] + i, c1);
+    simd::store_u (blocks.words [2] + i, c2);
+    simd::store_u (blocks.words [3] + i, c3);
+  }
+}
+
+
+/// <summary>
+/// every kernel built for one instruction set
+/// </summary>
+template <typename simd>
+constexpr tile_kernels_t make_tile_kernels (char const* name, kernel_isa_t isa)
+{
+  return
+  {
+    name,
+    isa,
+    &update_tiles_kernel <simd>,
+    &eat_tiles_kernel <simd>,
+    &bounce_tiles_kernel <simd>,
+    &transform_tiles_kernel <simd>,
+    &sincos_kernel <simd>,
+    &random_kernel <simd>,
+  };
+}
+
+
+} // namespace
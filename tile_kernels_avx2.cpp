@@ -0,0 +1,10 @@
+// TILE KERNELS: AVX2
+// 8 lanes, compiled with -mavx2 (/arch:AVX2)
+
+
+#include "simd_avx2.h" // for simd_avx2_t
+
+#include "tile_kernels.inl"
+
+
+tile_kernels_t const TILE_KERNELS_AVX2 = make_tile_kernels <simd_avx2_t> ("avx2", kernel_isa_t::AVX2);
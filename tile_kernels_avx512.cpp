@@ -0,0 +1,10 @@
+// TILE KERNELS: AVX512
+// 16 lanes, compiled with -mavx512f (/arch:AVX512)
+
+
+#include "simd_avx512.h" // for simd_avx512_t
+
+#include "tile_kernels.inl"
+
+
+tile_kernels_t const TILE_KERNELS_AVX512 = make_tile_kernels <simd_avx512_t> ("avx512", kernel_isa_t::AVX512);
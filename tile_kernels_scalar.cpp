@@ -0,0 +1,10 @@
+// TILE KERNELS: SCALAR
+// plain C++, no SIMD
+
+
+#include "simd_scalar.h" // for simd_scalar_t
+
+#include "tile_kernels.inl"
+
+
+tile_kernels_t const TILE_KERNELS_SCALAR = make_tile_kernels <simd_scalar_t> ("scalar", kernel_isa_t::SCALAR);
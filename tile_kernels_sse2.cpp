@@ -0,0 +1,10 @@
+// TILE KERNELS: SSE2
+// 4 lanes, every x86-64 CPU
+
+
+#include "simd_sse2.h" // for simd_sse2_t
+
+#include "tile_kernels.inl"
+
+
+tile_kernels_t const TILE_KERNELS_SSE2 = make_tile_kernels <simd_sse2_t> ("sse2", kernel_isa_t::SSE2);
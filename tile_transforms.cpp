@@ -0,0 +1,48 @@
+#include "tile_transforms.h"
+
+#include "tile_kernels.h" // for transform_tiles, transform_query_t
+#include "tiles.h"        // for tiles_t
+#include "utility.h"      // for aligned_allocate, aligned_release
+
+#include <cassert>        // for assert
+
+
+void initialise_tile_transforms (tile_transforms_t& transforms, unsigned capacity)
+{
+  transforms.capacity = capacity;
+
+  transforms.x_axis_x = (float*)aligned_allocate (capacity * sizeof (float));
+  transforms.x_axis_y = (float*)aligned_allocate (capacity * sizeof (float));
+  transforms.y_axis_x = (float*)aligned_allocate (capacity * sizeof (float));
+  transforms.y_axis_y = (float*)aligned_allocate (capacity * sizeof (float));
+  transforms.position_x = (float*)aligned_allocate (capacity * sizeof (float));
+  transforms.position_y = (float*)aligned_allocate (capacity * sizeof (float));
+}
+
+void build_tile_transforms (tile_transforms_t& transforms, tiles_t const& tiles, sprite_table_t const& sprites,
+  float interpolation, job_system_t& jobs)
+{
+  assert (transforms.capacity >= tiles.capacity);
+
+  transform_query_t query;
+  query.width_normal  = get_sprite_metrics (sprites, SPRITE_ID_TILE_NORMAL).width;
+  query.height_normal = get_sprite_metrics (sprites, SPRITE_ID_TILE_NORMAL).height;
+  query.width_wide    = get_sprite_metrics (sprites, SPRITE_ID_TILE_WIDE).width;
+  query.height_wide   = get_sprite_metrics (sprites, SPRITE_ID_TILE_WIDE).height;
+  query.prev_weight   = 1.f - interpolation;
+  query.angle_step    = tiles.angle_step;
+
+  transform_tiles (tiles, query, transforms, jobs);
+}
+
+void release_tile_transforms (tile_transforms_t& transforms)
+{
+  aligned_release (transforms.x_axis_x);
+  aligned_release (transforms.x_axis_y);
+  aligned_release (transforms.y_axis_x);
+  aligned_release (transforms.y_axis_y);
+  aligned_release (transforms.position_x);
+  aligned_release (transforms.position_y);
+
+  transforms = {};
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "sprites.h" // for sprite_table_t
+
+
+struct tiles_t; // forward declare
+struct job_system_t;
+
+
+// TILE TRANSFORMS
+//
+// Render prep: where each tile is drawn, worked out for every tile at once before any drawing starts.
+// A tile's model matrix is position * rotation * scale, but for a sprite in 2D only 6 of its 16 numbers ever change:
+//
+//   | x_axis_x  y_axis_x  0  position_x |   | cos * width   -sin * height  0  x |
+//   | x_axis_y  y_axis_y  0  position_y | = | sin * width    cos * height  0  y |
+//   | 0         0         1  0          |   | 0              0             1  0 |
+//   | 0         0         0  1          |   | 0              0             0  1 |
+//
+// so just those 6 are stored, one array each, and filled in 4/8/16 tiles at a time (see build_tile_transforms).
+
+
+struct tile_transforms_t
+{
+  unsigned capacity; // same as tiles.capacity, so SIMD code can run over whole vectors
+
+  // the sprite's x axis, rotated and scaled by its width
+  float* x_axis_x;
+  float* x_axis_y;
+  // the sprite's y axis, rotated and scaled by its height
+  float* y_axis_x;
+  float* y_axis_y;
+
+  float* position_x;
+  float* position_y;
+};
+
+
+/// <summary>
+/// allocate room for the transforms of { tiles.capacity } tiles
+/// </summary>
+void initialise_tile_transforms (tile_transforms_t& transforms, unsigned capacity);
+
+/// <summary>
+/// work out every tile's transform from its position, angle and sprite size
+/// </summary>
+/// <param name="interpolation">how far from the step before the last one to the last one to draw the tiles, in [0, 1]
+/// 1 = where they are now, see simulation_t::get_interpolation</param>
+void build_tile_transforms (tile_transforms_t& transforms, tiles_t const& tiles, sprite_table_t const& sprites,
+  float interpolation, job_system_t& jobs);
+
+/// <summary>
+/// releases the storage allocated by initialise_tile_transforms
+/// </summary>
+void release_tile_transforms (tile_transforms_t& transforms);
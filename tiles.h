@@ -1,202 +1,134 @@
 #pragma once
 
-#include "magpie.h"    // for magpie::renderer, magpie::_2d::sprite_batch, magpie::spritesheet
-
 #include "constants.h" // for object_type_t, object_id_t...
-#include "utility.h"   // for vector4, random_getf
+#include "random.h"    // for random_key_t, random_blocks_t
+#include "soa_pool.h"  // for soa_pool_t, real_t
 
-#include <map>         // for std::multimap
+#include <cstdint>     // for std::uint32_t, std::uint64_t
 
 
-// TILE
-//
-//struct tile_t
-//{
-//public:
-//  tile_t ();
-//
-//
-//  virtual void update (double elapsed, magpie::spritesheet spritesheet) = 0;
-//  virtual void render (magpie::renderer& renderer,
-//    magpie::_2d::sprite_batch& sprite_batch,
-//    magpie::spritesheet spritesheet) = 0;
-//
-//  /// <summary>
-//  /// the tile has collided with something
-//  /// check what type of object it is and resolve the collision appropriately
-//  /// </summary>
-//  /// <param name="other_type">the identifier of the other object</param>
-//  /// <param name="other_data">pointer to some data, could be another tile, a wall, or anything!</param>
-//  /// <param name="spritesheet">spritesheet data, required to get size of other object</param>
-//  virtual void on_collision (object_type_t other_type, void* other_data, magpie::spritesheet spritesheet) = 0;
-//  virtual object_id_t get_id () const = 0;
-//
-//  virtual bool needs_replacing () const = 0;
-//
+struct frame_arena_t; // forward declare
+struct job_system_t;
+
+
+// TILE FIELDS
 //
-//public:
-//  vector4 position;
-//  vector4 velocity;
-//  float angle_radians;
-//private:
-//    bool is_eaten;
-//};
+// One column of tiles_t each, see soa_pool.h.
+// Every tile is the same apart from its id: a wide tile is bigger, and expires after { TILE_WIDE_LIFETIIME } seconds.
 
+// the tile kernels work on float lanes, 16 tiles to an AVX-512 register
+precision_t const TILE_PRECISION = precision_t::SINGLE;
+using tile_real_t = real_t <TILE_PRECISION>;
 
-// TILE NORMAL
+// HOT: read and written by every step's per tile passes
+// a step's update pass touches one cache line of each of these per 16 tiles, and nothing else
+struct tile_pos_x_t { using value_t = tile_real_t; };
+struct tile_pos_y_t { using value_t = tile_real_t; };
+struct tile_vel_x_t { using value_t = tile_real_t; };
+struct tile_vel_y_t { using value_t = tile_real_t; };
+struct tile_angle_t { using value_t = tile_real_t; }; // radians
+// seconds left before a wide tile expires, counted down by update_tiles
+// normal tiles never expire, theirs is infinite, so the countdown needs no check of the tile's type
+struct tile_lifetime_t { using value_t = tile_real_t; };
+struct tile_object_id_t { using value_t = object_id_t; };
 
-/// <summary>
-/// consumed only when the player touches it
-/// </summary>
-//struct tile_normal_t : public tile_t
-//{
-//public:
-//  tile_normal_t ();
-//
-//  void update (double elapsed, magpie::spritesheet spritesheet) override;
-//  void render (magpie::renderer& renderer,
-//    magpie::_2d::sprite_batch& sprite_batch,
-//    magpie::spritesheet spritesheet) override;
-//
-//  void on_collision (object_type_t other_type, void* other_data, magpie::spritesheet spritesheet) override;
-//  object_id_t get_id () const override;
-//
-//  bool needs_replacing () const override;
-//
-//
-//private:
-//  bool is_eaten;
-//};
+// COLD: only written once a step, for the front end
+// where each tile was before the last step, saved by update_tiles
+// the front end draws tiles part way between here and where they are now (see build_tile_transforms)
+struct tile_prev_pos_x_t { using value_t = tile_real_t; };
+struct tile_prev_pos_y_t { using value_t = tile_real_t; };
+
+using tile_pool_t = soa_pool_t <
+  tile_pos_x_t, tile_pos_y_t, tile_vel_x_t, tile_vel_y_t, tile_angle_t, tile_lifetime_t, tile_object_id_t,
+  tile_prev_pos_x_t, tile_prev_pos_y_t>;
 
 
-// TILE WIDE
+// TILES
 
 /// <summary>
-/// consumed when player touches it or is deleted after { TILE_WIDE_LIFETIIME } seconds
-/// when consumed, makes the player bigger for an amount of time
+/// where new tiles are placed
 /// </summary>
-//struct tile_wide_t : public tile_t
-//{
-//public:
-//  tile_wide_t ();
-//
-//  void update (double elapsed, magpie::spritesheet spritesheet) override;
-//  void render (magpie::renderer& renderer,
-//    magpie::_2d::sprite_batch& sprite_batch,
-//    magpie::spritesheet spritesheet) override;
-//
-//  void on_collision (object_type_t other_type, void* other_data, magpie::spritesheet spritesheet) override;
-//  object_id_t get_id () const override;
-//
-//  bool needs_replacing () const override;
-//
-//
-//private:
-//  bool is_eaten;
-//  double lifetime;
-//};
+enum class tile_spawn_t
+{
+  UNIFORM,   // anywhere on the screen, as the original game does
+  CLUSTERED, // in a few small patches, a crowded workload for the tile v tile broadphase
+};
 
+/// <summary>
+/// every tile in the game, { count } of them, in the columns of a tile_pool_t
+/// plus the per step lists the tile stages hand each other, allocated from the step's frame arena
+/// </summary>
+struct tiles_t : tile_pool_t
+{
+    tile_spawn_t spawn;
 
-// GENERAL
+    // every tile turns by the same angle each step, so there is no per tile copy of the angle before it
+    float angle_step;
 
-struct tiles_t
-{
- //std::multimap <object_id_t, tile_t*> data;
-      
-
-  //  vector4 data[NUM_TILES];
-
- /*   alignas(16) vector4 position[NUM_TILES];
-    alignas(16) vector4 velocity[NUM_TILES];*/
-    alignas(16) float pos_x[NUM_TILES];
-    alignas(16) float pos_y[NUM_TILES];
-    alignas(16) float vel_x[NUM_TILES];
-    alignas(16) float vel_y[NUM_TILES];
-
-    alignas(16) float angle_radians[NUM_TILES];
-    alignas(16) bool is_eaten[NUM_TILES];
-    alignas(16) double lifetime[NUM_TILES];
-
-    alignas(16) object_id_t tile_id[NUM_TILES];
-    alignas(16) bool active[NUM_TILES];
-
-
-
-    void update(double elapsed, magpie::spritesheet spritesheet);
-    void render(magpie::renderer& renderer,
-        magpie::_2d::sprite_batch& sprite_batch,
-        magpie::spritesheet spritesheet);
-
-    /// <summary>
-    /// the tile has collided with something
-    /// check what type of object it is and resolve the collision appropriately
-    /// </summary>
-    /// <param name="other_type">the identifier of the other object</param>
-    /// <param name="other_data">pointer to some data, could be another tile, a wall, or anything!</param>
-    /// <param name="spritesheet">spritesheet data, required to get size of other object</param>
-    void on_collision(object_type_t other_type, void* other_data, magpie::spritesheet spritesheet, int tile_index);
-
-    object_id_t get_id(int index) const;
-    
-    bool needs_replacing(int index) const;
-    /*
-
-    int index[NUM_TILES];
-
-    bool begin() 
-    {
-        if (index == 0)
-        {
-            return true;
-        }
-        else
-        {
-            return false;
-        }
-    }
-
-    int size()
-    {
-        return (sizeof(index) / sizeof(*index));
-    }
-
-    bool end()
-    {
-        if (index == )
-        {
-            return true;
-        }
-        else
-        {
-            return false;
-        }
-    }
-    */
+    // one bit per tile, set for each tile that needs replacing, e.g. eaten by the player
+    // packed 64 to a word, { capacity } bits rounded up to a whole word
+    // whichever stage decides a tile is done with sets its bit (see mark_tile_for_respawn),
+    // replace_expired_tiles respawns every tile with its bit set and clears them all again
+    std::uint64_t* respawn_bits;
 
+    // filled in by replace_expired_tiles: the tiles it is replacing, lowest first, and the random bits for each new tile
+    // from the frame arena, only valid until the end of the step
+    std::uint32_t* expired_indices;
+    unsigned num_expired;
+    random_blocks_t spawn_random;
+
+    // every new tile's position etc. comes from (key, spawn round, tile index), see random.h
+    random_key_t random_key;
+    std::uint32_t spawn_round; // times replace_expired_tiles has run
+
+    // tiles eaten by the player this step, filled in by eat_tiles
+    // from the frame arena, only valid until the end of the step
+    unsigned* eaten_indices;
+    unsigned num_eaten;
+
+
+    void update(double elapsed, job_system_t& jobs);
 };
 
 
+/// <summary>
+/// tiles per word of tiles_t::respawn_bits
+/// </summary>
+unsigned const TILES_PER_RESPAWN_WORD = 64u;
+
+/// <summary>
+/// flag tile { index } to be replaced by the next replace_expired_tiles
+/// only touches the word holding { index }, so threads working on different words can mark tiles at the same time
+/// </summary>
+inline void mark_tile_for_respawn (tiles_t& tiles, unsigned index)
+{
+  tiles.respawn_bits [index / TILES_PER_RESPAWN_WORD] |= std::uint64_t (1) << (index % TILES_PER_RESPAWN_WORD);
+}
+
+
 /// <summary>
 /// pre game loop tiles set up code
+/// allocates storage for { count } tiles and spawns them
+/// the same { seed } always spawns the same tiles
+/// { spawn } is where they, and every tile that replaces one, are placed
+/// { arena } holds the lists used to spawn them, and can be reset straight afterwards
 /// </summary>
-void initialise_tiles (tiles_t& tiles);
+void initialise_tiles (tiles_t& tiles, unsigned count, std::uint64_t seed, tile_spawn_t spawn, frame_arena_t& arena, job_system_t& jobs);
 
 /// <summary>
 /// remove 'expired' tiles, e.g. eaten by player, lifetime has expired
 /// replace removed tiles with new ones
-/// the game requires that there are always { NUM_TILES } active
+/// only the tiles marked in tiles.respawn_bits are visited, so this costs next to nothing when few tiles expire
+/// the new tiles are made over { jobs }' threads, each tile's from its own random numbers,
+/// so they come out the same however many threads there are
+/// the lists of expired tiles and their random numbers come from { arena }
+/// the game requires that there are always { tiles.count } active
 /// </summary>
-void replace_expired_tiles (tiles_t& tiles);
+void replace_expired_tiles (tiles_t& tiles, frame_arena_t& arena, job_system_t& jobs);
 
 /// <summary>
 /// post game loop tiles tear down code
+/// releases the storage allocated by initialise_tiles
 /// </summary>
 void release_tiles (tiles_t& tiles);
 
-
-/// <summary>
-/// search the spritesheet for the sub-sprite associated with a particular type of tile
-/// NOTE: this app uses the size of the sub-sprite as the size of the object in the game world.
-/// </summary>
-/// <returns>a pointer to the texture_rect of the object's sub-sprite on the spritesheet</returns>
-texture_rect const* get_tile_texture_rect (magpie::spritesheet& spritesheet, object_id_t id);
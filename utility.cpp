@@ -1,15 +1,43 @@
 #include "utility.h"
 
-#include "magpie.h" // for MAGPIE_DASSERT
+#include <new> // for operator new, std::align_val_t
 
-#include <cstdlib>  // for rand
+#if defined (__x86_64__) || defined (_M_X64)
+#include <immintrin.h> // for _mm_pause
+#endif
 
 
-double random_getd (double min, double max)
+void* aligned_allocate (std::size_t bytes)
 {
-  MAGPIE_DASSERT (max > min);
-  double const random = (double)rand () / (double)RAND_MAX;
-  double const range = max - min;
+  return ::operator new (bytes, std::align_val_t (CACHE_LINE_SIZE));
+}
+
+void aligned_release (void* memory)
+{
+  ::operator delete (memory, std::align_val_t (CACHE_LINE_SIZE));
+}
+
+
+// how many times to check before going to sleep
+// threads handing work back and forth within a frame do so a few microseconds apart,
+// this is long enough to cover that and short enough not to hog a core
+unsigned const SPIN_COUNT = 1u << 12;
+
+unsigned wait_for_change (std::atomic <unsigned> const& value, unsigned old)
+{
+  unsigned current = value.load (std::memory_order_acquire);
+  for (unsigned spin = 0; current == old && spin < SPIN_COUNT; spin++)
+  {
+#if defined (__x86_64__) || defined (_M_X64)
+    _mm_pause (); // tell the core this thread is spinning, so it can give the pipeline to its hyperthread
+#endif
+    current = value.load (std::memory_order_acquire);
+  }
+  while (current == old)
+  {
+    value.wait (old, std::memory_order_acquire);
+    current = value.load (std::memory_order_acquire);
+  }
 
-  return (random * range) + min;
+  return current;
 }
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <atomic>  // for std::atomic
+#include <cstddef> // for std::size_t
+
 
 struct vector4
 {
@@ -11,9 +14,27 @@ struct vector4
 
 
 /// <summary>
-/// returns a number between min and max inclusive
+/// size of a cache line, in bytes
+/// also wide enough for the widest SIMD register we use (AVX-512, 16 floats)
+/// </summary>
+std::size_t const CACHE_LINE_SIZE = 64u;
+
+/// <summary>
+/// allocate memory aligned to { CACHE_LINE_SIZE } bytes
+/// memory is NOT initialised, release with aligned_release
+/// </summary>
+void* aligned_allocate (std::size_t bytes);
+
+/// <summary>
+/// release memory allocated with aligned_allocate
+/// </summary>
+void aligned_release (void* memory);
+
+
+/// <summary>
+/// block until { value } is no longer { old }, for threads handing work to each other
+/// spins for a few microseconds first, so a quick handover never goes through the OS,
+/// then sleeps until whoever changes it calls notify_one/notify_all
 /// </summary>
-/// <param name="min">minimum random number (inclusive)</param>
-/// <param name="max">maximum random number (inclusive)</param>
-/// <returns>random number between min & max (inclusive)</returns>
-double random_getd (double min, double max);
+/// <returns>the new value</returns>
+unsigned wait_for_change (std::atomic <unsigned> const& value, unsigned old);
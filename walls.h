@@ -1,47 +1,34 @@
 #pragma once
 
-#include "magpie.h"    // for magpie::renderer, magpie::_2d::sprite_batch, magpie::spritesheet
-
 #include "constants.h" // for object_id_t, object_type_t...
+#include "soa_pool.h"  // for soa_pool_t, real_t
 #include "utility.h"   // for vector4
 
-#include <list>        // for std::list
-
-
-class wall_t
-{
-public:
-  wall_t () = delete;
-  wall_t (double size, vector4 position, object_id_t id);
-
-  void render (magpie::renderer& renderer,
-    magpie::_2d::sprite_batch& sprite_batch,
-    magpie::spritesheet spritesheet);
 
-  /// <summary>
-  /// the wall has collided with something
-  /// check what type of object it is and resolve the collision appropriately
-  /// </summary>
-  /// <param name="other_type">the identifier of the other object</param>
-  /// <param name="other_data">pointer to some data, could be a tile, a player, or anything!</param>
-  /// <param name="spritesheet">spritesheet data, required to get size of other object</param>
-  void on_collision (object_type_t other_type, void* other_data, magpie::spritesheet spritesheet, int index);
-  object_id_t get_id () const;
+// WALL FIELDS
+//
+// One column of walls_t each, see soa_pool.h.
+// walls never react to being hit, see collision_handler_t in collision.h
 
+// there are only 4 walls and nothing runs over them a vector at a time, so they keep the precision they were placed with
+precision_t const WALL_PRECISION = precision_t::DOUBLE;
+using wall_real_t = real_t <WALL_PRECISION>;
 
-public:
-  double size; // x & y dimension
-  vector4 position;
+struct wall_size_t { using value_t = wall_real_t; }; // x & y dimension
+struct wall_position_x_t { using value_t = wall_real_t; };
+struct wall_position_y_t { using value_t = wall_real_t; };
+struct wall_object_id_t { using value_t = object_id_t; };
 
+using wall_pool_t = soa_pool_t <wall_size_t, wall_position_x_t, wall_position_y_t, wall_object_id_t>;
 
-private:
-  object_id_t id;
-};
 
+// WALLS
 
-struct walls_t
+/// <summary>
+/// every wall in the game, { count } of them, in the columns of a wall_pool_t
+/// </summary>
+struct walls_t : wall_pool_t
 {
-  std::list <wall_t> data;
 };
 
 